@@ -0,0 +1,95 @@
+#ifndef ARCHIVE_EXTRACTOR_H
+#define ARCHIVE_EXTRACTOR_H
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <QString>
+
+#include "ifiletree.h"
+#include "iinstallationmanager.h"
+
+/**
+ * @brief Extract entries from the archive being installed on demand.
+ *
+ * Each extraction goes through the whole archive (which is slow for solid archives), so
+ * the entries the script is expected to read (see expect()) are extracted together with
+ * the first entry requested with extract(), in a single call. The installation manager
+ * cannot be used from another thread, so nothing is extracted before it is requested.
+ */
+class ArchiveExtractor {
+public:
+
+  using EntryPtr = std::shared_ptr<const MOBase::FileTreeEntry>;
+
+  /**
+   * @brief Create a new extractor.
+   *
+   * @param manager The installation manager to extract with.
+   * @param extracted Entries that have already been extracted, with their paths.
+   */
+  ArchiveExtractor(MOBase::IInstallationManager* manager, std::map<EntryPtr, QString> extracted) :
+    m_Manager(manager), m_Extracted(std::move(extracted)) { }
+
+  /**
+   * @brief Extract the given entry.
+   *
+   * If the entry has already been extracted, the existing path is returned. Otherwise,
+   * the expected entries that have not been extracted yet are extracted with it.
+   *
+   * @param entry The entry to extract.
+   *
+   * @return path to the temporary file corresponding to the entry, or an empty string
+   *     if the extraction failed.
+   */
+  QString extract(EntryPtr const& entry) {
+    if (auto it = m_Extracted.find(entry); it != m_Extracted.end()) {
+      return it->second;
+    }
+
+    std::vector<EntryPtr> batch{ entry };
+    for (EntryPtr const& expected : m_Expected) {
+      if (expected != entry && m_Extracted.find(expected) == m_Extracted.end()) {
+        batch.push_back(expected);
+      }
+    }
+    m_Expected.clear();
+
+    if (batch.size() > 1) {
+      QStringList paths = m_Manager->extractFiles(batch);
+      if (paths.size() == static_cast<int>(batch.size())) {
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+          m_Extracted.emplace(batch[i], paths[i]);
+        }
+        return paths[0];
+      }
+
+      // If something went wrong, the expected entries are extracted when requested:
+    }
+
+    QString path = m_Manager->extractFile(entry, true);
+    if (!path.isEmpty()) {
+      m_Extracted[entry] = path;
+    }
+
+    return path;
+  }
+
+  /**
+   * @brief Add entries to extract with the next entry requested with extract().
+   *
+   * @param entries The entries the script is expected to read.
+   */
+  void expect(std::vector<EntryPtr> const& entries) {
+    m_Expected.insert(m_Expected.end(), entries.begin(), entries.end());
+  }
+
+private:
+
+  MOBase::IInstallationManager* m_Manager;
+  std::map<EntryPtr, QString> m_Extracted;
+  std::vector<EntryPtr> m_Expected;
+};
+
+#endif
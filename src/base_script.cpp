@@ -17,18 +17,29 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "base_script.h"
 
-#include <filesystem>
+#using <System.Core.dll>
+
+#include <algorithm>
 #include <map>
+#include <unordered_map>
+#include <utility>
+
+#include <vcclr.h>
+#include <set>
+#include <string_view>
 
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QCheckBox>
 #include <QRadioButton>
 #include <QInputDialog>
-#include <QSettings>
 #include <QDialogButtonBox>
 #include <QPushButton>
 #include <QVersionNumber>
 #include <QLabel>
+#include <QTextDocument>
 #include <QVBoxLayout>
 
 #include "imoinfo.h"
@@ -39,10 +50,20 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "scriptextender.h"
 
+#include "archive_extractor.h"
+#include "data_index.h"
+#include "file_cache.h"
+#include "install_batch.h"
+#include "ini_file.h"
 #include "psettings.h"
 #include "installer_fomod_postdialog.h"
+#include "plugin_journal.h"
 #include "csharp_interface.h"
 #include "csharp_utils.h"
+#include "script_compiler.h"
+#include "script_rewriter.h"
+#include "source_index.h"
+#include "wildcard.h"
 
 using namespace MOBase;
 
@@ -51,6 +72,47 @@ namespace CSharp {
   // Pointer to object:
   static MOBase::IOrganizer* g_Organizer;
 
+  // String literals longer than this are not considered as potential paths:
+  static constexpr std::size_t MAX_LITERAL_PATH_LENGTH = 260;
+
+  // Origin of an entry in the destination tree:
+  struct Origin {
+    enum Type {
+      ARCHIVE,  // Copied from the archive, index is the index of the source entry.
+      CREATED,  // Created by the script, path is the temporary file.
+      MERGE     // Directory with entries from multiple origins.
+    };
+
+    Type type;
+    int index;
+    QString path;
+  };
+
+  // Parsed INI file:
+  struct IniTable {
+    // Size and modification time of the file when it was parsed:
+    qint64 Size = -1;
+    QDateTime LastModified;
+
+    // Map from case-folded "section/key" to value:
+    QHash<QString, QString> Values;
+  };
+
+  // Snapshot of the plugin list:
+  struct PluginSnapshot {
+    // Plugins, in load order:
+    QStringList Names;
+    std::vector<IPluginList::PluginStates> States;
+    std::vector<int> Priorities;
+
+    // Map from case-folded name to index:
+    QHash<QString, int> Indices;
+
+    // Managed lists of plugins, computed on first use:
+    gcroot<array<System::String^>^> AllPlugins;
+    gcroot<array<System::String^>^> ActivePlugins;
+  };
+
   // Per-install globals:
   struct Globals {
     IInstallationManager* InstallManager;
@@ -58,24 +120,54 @@ namespace CSharp {
     std::shared_ptr<const IFileTree> SourceTree;
     std::shared_ptr<IFileTree> DestinationTree;
 
-    // Map from path in destination entry to the original entry:
-    std::map<std::shared_ptr<const FileTreeEntry>, 
-      std::shared_ptr<const FileTreeEntry>> InstalledEntries;
+    // Flat index of the source tree, for look-ups by path:
+    SourceIndex Index;
+
+    // Index of the virtual data directory, populated on demand:
+    DataIndex Data;
+
+    // Index of the fomod folder in the source index:
+    int FomodIndex = SourceIndex::NONE;
+
+    // Origin of the entries inserted in the destination tree by the script (the origin
+    // of the other entries is found from their closest registered ancestor, see
+    // originOf()):
+    std::unordered_map<std::shared_ptr<const FileTreeEntry>, Origin> Origins;
+
+    // True if PerformBasicInstall() has been called but the destination tree has not
+    // been populated yet, in which case the destination tree is empty:
+    bool BasicInstallPending = false;
+
+    // Extractor for the entries of the original tree:
+    std::unique_ptr<ArchiveExtractor> Extractor;
 
-    // Map extracted entries (in the original tree) to (temporary) paths:
-    std::map<std::shared_ptr<const FileTreeEntry>, QString> ExtractedEntries;
+    // Content of the files read by the script:
+    FileCache Cache;
 
-    // Map creted entries (in the destination tree) to (temporary) paths:
-    std::map<std::shared_ptr<const FileTreeEntry>, QString> CreatedEntries;
+    // List of files in the mod (see GetModFileList()), computed on first use:
+    gcroot<array<System::String^>^> ModFileList;
 
-    // List of modified settings values:
+    // List of modified settings values, by INI file (as named by the game, see
+    // gameIniFile()):
     std::map<QString, PSettings> Settings;
 
+    // Parsed INI files, by case-folded name:
+    std::map<QString, IniTable> IniFiles;
+
+    // Plugin list, see plugins():
+    std::unique_ptr<PluginSnapshot> Plugins;
+
+    // Operations on the plugin list, see journal():
+    std::unique_ptr<PluginJournal> Journal;
+
     Globals() { }
     Globals(
       IPlugin const* plugin,MOBase::IInstallationManager* manager, QWidget* parentWidget, 
       std::shared_ptr<MOBase::IFileTree> tree, std::map<std::shared_ptr<const FileTreeEntry>, QString> entries) :
-        m_Plugin(plugin), InstallManager(manager), ParentWidget(parentWidget), SourceTree(tree), DestinationTree(tree->createOrphanTree()), ExtractedEntries(std::move(entries)) {
+        m_Plugin(plugin), InstallManager(manager), ParentWidget(parentWidget), SourceTree(tree), DestinationTree(tree->createOrphanTree()),
+        Index(tree), Data(g_Organizer), FomodIndex(Index.find("fomod")),
+        Extractor(std::make_unique<ArchiveExtractor>(manager, std::move(entries))),
+        Cache(g_Organizer->pluginSetting(plugin->name(), "cache_size").toLongLong() * 1024 * 1024) {
 
     }
 
@@ -90,24 +182,379 @@ namespace CSharp {
   };
   static Globals g;
 
+  // Plugin operations from the last installation, with the profile they were made for.
+  // They are applied on the first refresh of the plugin list after the installation
+  // (i.e., once the plugins of the mod are in the list), or dropped if the refresh is
+  // for another profile:
+  static std::unique_ptr<PluginJournal> g_PendingPluginJournal;
+  static QString g_PendingPluginJournalProfile;
+
+  void applyPendingPluginJournal() {
+    if (g_PendingPluginJournal == nullptr) {
+      return;
+    }
+
+    // Reset first since applying the journal may refresh the plugin list:
+    auto journal = std::move(g_PendingPluginJournal);
+    const QString profile = std::exchange(g_PendingPluginJournalProfile, QString());
+
+    if (g_Organizer->profileName() != profile) {
+      log::warn("C#: the profile changed after the installation, plugin changes for '{}' dropped.", profile);
+      return;
+    }
+
+    const QStringList skipped = journal->apply(g_Organizer->pluginList());
+    if (!skipped.isEmpty()) {
+      log::warn("C#: plugins not found after the installation, changes skipped: {}.", skipped.join(", "));
+    }
+  }
+
 
 
   void init(MOBase::IOrganizer* moInfo) {
     g_Organizer = moInfo;
+    initCompiler(QDir(moInfo->pluginDataPath()).filePath("installer_fomod_csharp/cache"));
+    moInfo->pluginList()->onRefreshed(&applyPendingPluginJournal);
   }
 
   void beforeInstall(IPlugin const* plugin, MOBase::IInstallationManager* manager, QWidget* parentWidget, 
-    std::shared_ptr<MOBase::IFileTree> tree, std::map<std::shared_ptr<const FileTreeEntry>, QString> entries) {
+    std::shared_ptr<MOBase::IFileTree> tree, std::map<std::shared_ptr<const FileTreeEntry>, QString> entries, QString const& script) {
     g = { plugin, manager, parentWidget, tree, std::move(entries) };
+
+    // The previous installation did not complete:
+    g_PendingPluginJournal.reset();
+    g_PendingPluginJournalProfile = QString();
+
+    // Files that the script is expected to read are extracted together with the first
+    // file it reads: files passed to the functions reading files from the mod or to the
+    // selection functions (previews), and the content of the fomod folder:
+    std::vector<std::shared_ptr<const FileTreeEntry>> expected;
+    std::set<int> queued;
+    auto enqueue = [&](int index) {
+      if (index != SourceIndex::NONE && g.Index.isFile(index) && queued.insert(index).second) {
+        expected.push_back(g.Index.entry(index));
+      }
+    };
+
+    static const std::set<std::u16string_view> readers = {
+      u"GetFileFromMod", u"GetFileFromFomod", u"OpenFileFromMod", u"GetFileRangeFromMod",
+      u"Select", u"SelectOption"
+    };
+    forEachStringLiteral(std::u16string_view(reinterpret_cast<const char16_t*>(script.utf16()), script.size()),
+      [&](std::u16string_view call, std::u16string const& literal) {
+        if (!literal.empty() && literal.size() < MAX_LITERAL_PATH_LENGTH && readers.count(call) > 0) {
+          enqueue(g.Index.find(QString::fromStdU16String(literal)));
+        }
+      });
+
+    if (int fomod = g.FomodIndex; fomod != SourceIndex::NONE && g.Index.isDir(fomod)) {
+      for (int i = fomod + 1; i < g.Index.end(fomod); ++i) {
+        enqueue(i);
+      }
+    }
+
+    g.Extractor->expect(expected);
+  }
+
+  void endInstall() {
+    if (g.Cache.hits() + g.Cache.misses() > 0) {
+      log::debug("File cache: {} hits, {} misses.", g.Cache.hits(), g.Cache.misses());
+    }
+    g = Globals();
+  }
+
+  /**
+   * @brief Find the INI file of the managed game with the given name.
+   *
+   * Scripts do not always use the same case as the game (e.g. skyrim.ini), so this is
+   * used to key the modified settings, like plugins() does with case-folded names.
+   *
+   * @param fileName Name of the INI file, as given by the script.
+   *
+   * @return the name of the INI file as listed by the game, or an empty string if the
+   *     file is not an INI file of the game.
+   */
+  QString gameIniFile(QString const& fileName) {
+    for (auto ini : g_Organizer->managedGame()->iniFiles()) {
+      if (ini.compare(fileName, Qt::CaseInsensitive) == 0) {
+        return ini;
+      }
+    }
+    return QString();
+  }
+
+  /**
+   * @return the path to the given INI file for the current profile.
+   */
+  QString iniFilePath(QString const& fileName) {
+    QDir path(g_Organizer->profilePath());
+    if (!g_Organizer->profile()->localSettingsEnabled()) {
+      path = QDir(g_Organizer->managedGame()->documentsDirectory());
+    }
+    return path.filePath(fileName);
+  }
+
+  /**
+   * @return the key of the given section and key in an IniTable.
+   */
+  QString iniKey(QString const& section, QString const& key) {
+    return section.toCaseFolded() + '/' + key.toCaseFolded();
+  }
+
+  /**
+   * @brief Retrieve the content of the given INI file of the current profile.
+   *
+   * Files are parsed once per installation, and parsed again only if they have been
+   * modified in-between.
+   *
+   * @param fileName Name of the INI file.
+   *
+   * @return the parsed file, or a null pointer if the file could not be read.
+   */
+  IniTable const* iniTable(QString const& fileName) {
+    QFileInfo info(iniFilePath(fileName));
+    IniTable& table = g.IniFiles[fileName.toCaseFolded()];
+    if (table.Size == info.size() && table.LastModified == info.lastModified()) {
+      return &table;
+    }
+
+    table = IniTable();
+    QFile file(info.filePath());
+    if (file.exists()) {
+      if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+      }
+
+      QByteArray content;
+      const qint64 size = file.size();
+      const char* data = size > 0 ? reinterpret_cast<const char*>(file.map(0, size)) : "";
+      if (data == nullptr) {
+        content = file.readAll();
+        data = content.constData();
+      }
+
+      // Game INI files are in the ANSI code page, unless they have a BOM (see also
+      // PSettings::update()):
+      IniDocument document(std::string_view(data, static_cast<std::size_t>(size)));
+      auto decode = [utf8 = document.hasUtf8Bom()](std::string_view value) {
+        return utf8 ? QString::fromUtf8(value.data(), static_cast<int>(value.size()))
+          : QString::fromLocal8Bit(value.data(), static_cast<int>(value.size()));
+      };
+      for (auto const& entry : document.entries()) {
+        // Keys before the first section are in the General section, as with QSettings,
+        // and take precedence over the keys of an actual [General] section:
+        QString key = iniKey(entry.section.empty() ? QString("General") : decode(entry.section), decode(entry.key));
+        if (!table.Values.contains(key)) {
+          table.Values.insert(key, decode(entry.value));
+        }
+      }
+    }
+
+    table.Size = info.size();
+    table.LastModified = info.lastModified();
+    return &table;
+  }
+
+  /**
+   * @brief Remove the modified settings values that are identical to the current ones,
+   * and the files without any remaining modification.
+   */
+  void dropUnchangedSettings() {
+    for (auto it = g.Settings.begin(); it != g.Settings.end(); ) {
+      IniTable const* table = iniTable(it->first);
+
+      PSettings changed;
+      it->second.forEach([&](QString const& section, QString const& key, QString const& value) {
+        if (table != nullptr) {
+          auto vIt = table->Values.find(iniKey(section, key));
+          if (vIt != table->Values.end() && vIt.value() == value) {
+            return;
+          }
+        }
+        changed.setValue(section, key, value);
+      });
+
+      if (changed.empty()) {
+        it = g.Settings.erase(it);
+      }
+      else {
+        it->second = std::move(changed);
+        ++it;
+      }
+    }
+  }
+
+  /**
+   * @brief Register the origin of the given copy of a source entry.
+   *
+   * The descendants of a copied directory are not registered, their origin is resolved
+   * on demand from their path relative to the copy, see originOf().
+   *
+   * @param copy The copy, in the destination tree.
+   * @param index Index of the source entry.
+   * @param merged True if the copy was merged into an existing directory.
+   */
+  void registerCopy(std::shared_ptr<const FileTreeEntry> copy, int index, bool merged) {
+    g.Origins[copy] = { merged ? Origin::MERGE : Origin::ARCHIVE, index, QString() };
+  }
+
+  /**
+   * @brief Remove the origins of the entries that are no longer in the destination tree,
+   * i.e. entries that have been replaced or removed.
+   */
+  void dropDetachedOrigins() {
+    for (auto it = g.Origins.begin(); it != g.Origins.end(); ) {
+      auto parent = it->first->parent();
+      while (parent != nullptr && parent != g.DestinationTree) {
+        parent = parent->parent();
+      }
+      if (parent == nullptr) {
+        it = g.Origins.erase(it);
+      }
+      else {
+        ++it;
+      }
+    }
+  }
+
+  /**
+   * @brief Find the origin of the given entry of the destination tree.
+   *
+   * @param entry The entry, in the destination tree.
+   *
+   * @return the origin of the entry (MERGE without index if the entry has no known
+   *     origin, e.g. directories created implicitly).
+   */
+  Origin originOf(std::shared_ptr<const FileTreeEntry> const& entry) {
+    // Find the closest registered ancestor:
+    std::shared_ptr<const FileTreeEntry> ancestor = entry;
+    auto it = g.Origins.find(ancestor);
+    while (it == g.Origins.end() && ancestor->parent() != nullptr) {
+      ancestor = ancestor->parent();
+      it = g.Origins.find(ancestor);
+    }
+
+    if (it == g.Origins.end()) {
+      return { Origin::MERGE, SourceIndex::NONE, QString() };
+    }
+    if (ancestor == entry) {
+      return it->second;
+    }
+
+    // The entry comes from the copied directory if the source directory has an entry of
+    // the same type at the same path:
+    if (it->second.type != Origin::CREATED && it->second.index != SourceIndex::NONE) {
+      int index = g.Index.find(entry->pathFrom(ancestor->astree(), "/"), it->second.index);
+      if (index != SourceIndex::NONE && g.Index.isDir(index) == entry->isDir()) {
+        return { Origin::ARCHIVE, index, QString() };
+      }
+    }
+
+    return { Origin::MERGE, SourceIndex::NONE, QString() };
+  }
+
+  /**
+   * @brief Populate the destination tree if PerformBasicInstall() has been called.
+   *
+   * The entries are copied since the source tree belongs to the installation manager.
+   */
+  void applyBasicInstall() {
+    if (!g.BasicInstallPending) {
+      return;
+    }
+    g.BasicInstallPending = false;
+
+    bool replaced = false;
+    for (int i = SourceIndex::ROOT + 1; i < g.Index.size(); i = g.Index.end(i)) {
+      if (i == g.FomodIndex) {
+        continue;
+      }
+
+      auto entry = g.Index.entry(i);
+      auto existing = g.DestinationTree->find(entry->name());
+      if (auto ce = g.DestinationTree->copy(entry, "", IFileTree::InsertPolicy::MERGE); ce != nullptr) {
+        registerCopy(ce, i, existing != nullptr && existing->isDir() && entry->isDir());
+        replaced |= existing != nullptr;
+      }
+    }
+
+    // Merging replaces the existing files with the same path:
+    if (replaced) {
+      dropDetachedOrigins();
+    }
+  }
+
+  /**
+   * @brief Retrieve the destination tree for modification.
+   *
+   * @return the destination tree, populated if PerformBasicInstall() has been called.
+   */
+  std::shared_ptr<IFileTree> destinationTree() {
+    applyBasicInstall();
+    return g.DestinationTree;
+  }
+
+  /**
+   * @brief Look up the given path in the destination tree, without populating it.
+   *
+   * @param path Path to look up.
+   * @param origin Set to the origin of the entry, see originOf().
+   *
+   * @return the type of the entry (FILE or DIRECTORY), or no flag if there is no entry
+   *     at the given path.
+   */
+  FileTreeEntry::FileTypes findDestination(QString const& path, Origin& origin) {
+    if (g.BasicInstallPending) {
+      // The destination is the source tree without the fomod folder:
+      int index = g.Index.find(path);
+      if (index == SourceIndex::NONE || index == SourceIndex::ROOT
+        || (g.FomodIndex != SourceIndex::NONE && index >= g.FomodIndex && index < g.Index.end(g.FomodIndex))) {
+        return {};
+      }
+      origin = { Origin::ARCHIVE, index, QString() };
+      return g.Index.isDir(index) ? FileTreeEntry::DIRECTORY : FileTreeEntry::FILE;
+    }
+
+    auto entry = g.DestinationTree->find(path);
+    if (entry == nullptr) {
+      return {};
+    }
+
+    origin = originOf(entry);
+    return entry->isDir() ? FileTreeEntry::DIRECTORY : FileTreeEntry::FILE;
   }
 
   IPluginInstaller::EInstallResult postInstall(std::shared_ptr<MOBase::IFileTree>& tree) {
 
-    if (!g.Settings.empty()) {
+    // If the script did not modify the destination tree after PerformBasicInstall(), the
+    // tree given to the installer is installed as is (without the fomod folder) instead
+    // of being copied:
+    if (g.BasicInstallPending && g.DestinationTree->empty() && tree == g.SourceTree) {
+      g.BasicInstallPending = false;
+      if (g.FomodIndex != SourceIndex::NONE) {
+        if (auto fomod = tree->find(g.Index.name(g.FomodIndex).toString()); fomod != nullptr) {
+          fomod->detach();
+        }
+      }
+      g.DestinationTree = tree;
+    }
+    applyBasicInstall();
+
+    // Only show (and write) the values that actually change:
+    dropUnchangedSettings();
+
+    if (g.Journal != nullptr && g.Journal->empty()) {
+      g.Journal.reset();
+    }
+
+    if (!g.Settings.empty() || g.Journal != nullptr) {
 
       InstallerFomodPostDialog* dialog = new InstallerFomodPostDialog(g.ParentWidget);
 
       dialog->setIniSettings(g.Settings);
+      if (g.Journal != nullptr) {
+        dialog->setPluginChanges(g.Journal->toString());
+      }
 
       // Installation cancelled:
       if (dialog->exec() == QDialog::Rejected) {
@@ -117,23 +564,16 @@ namespace CSharp {
       switch (dialog->result()) {
 
       // Discard, nothing do to:
-      case InstallerFomodPostDialog::Result::DISCARD: break;
+      case InstallerFomodPostDialog::Result::DISCARD:
+        g.Journal.reset();
+        break;
 
       // Apply, must fetch the profile INI settings and apply the settings:
       case InstallerFomodPostDialog::Result::APPLY: {
         for (auto& p : g.Settings) {
-          QDir path(g_Organizer->profilePath());
-          if (!g_Organizer->profile()->localSettingsEnabled()) {
-            path = QDir(g_Organizer->managedGame()->documentsDirectory());
-          }
-
-          QSettings settings(path.filePath(p.first), QSettings::IniFormat);
-
-          if (settings.status() != QSettings::NoError) {
+          if (!p.second.update(iniFilePath(p.first))) {
             return IPluginInstaller::EInstallResult::RESULT_FAILED;
           }
-
-          p.second.update(settings);
         }
       } break;
 
@@ -148,11 +588,9 @@ namespace CSharp {
           if (path.isEmpty()) {
             return IPluginInstaller::EInstallResult::RESULT_FAILED;
           }
-          QSettings settings(path, QSettings::IniFormat);
-          if (settings.status() != QSettings::NoError) {
+          if (!p.second.update(path)) {
             return IPluginInstaller::EInstallResult::RESULT_FAILED;
           }
-          p.second.update(settings);
         }
       } break;
       }
@@ -161,8 +599,14 @@ namespace CSharp {
 
     tree = g.DestinationTree;
 
+    // The plugins of the mod are only in the list after the installation:
+    if (g.Journal != nullptr) {
+      g_PendingPluginJournal = std::move(g.Journal);
+      g_PendingPluginJournalProfile = g_Organizer->profileName();
+    }
+
     // Clear up:
-    g = Globals();
+    endInstall();
 
 
     return IPluginInstaller::EInstallResult::RESULT_SUCCESS;
@@ -173,91 +617,271 @@ namespace CSharp {
 namespace CSharp {
 
   using namespace System::IO;
+  using namespace System::IO::MemoryMappedFiles;
 
-  bool isFomodEntry(std::shared_ptr<const FileTreeEntry> entry) {
-    return entry->pathFrom(g.SourceTree).compare("fomod", Qt::CaseInsensitive) == 0;
+  /**
+   * @brief Read-only stream over a memory-mapped file, that owns its view.
+   */
+  ref class MappedFileStream : public UnmanagedMemoryStream {
+  public:
+
+    MappedFileStream(MemoryMappedViewAccessor^ view, Int64 length) :
+      UnmanagedMemoryStream(view->SafeMemoryMappedViewHandle, 0, length, FileAccess::Read), m_View(view) { }
+
+    ~MappedFileStream() {
+      delete m_View;
+    }
+
+  private:
+    MemoryMappedViewAccessor^ m_View;
+  };
+
+  /**
+   * @brief Open the given file as a memory-mapped stream.
+   *
+   * @param path Path to the file.
+   *
+   * @return a read-only stream over the file.
+   */
+  Stream^ openMappedFile(QString const& path) {
+    FileStream^ file = gcnew FileStream(from_string(path), FileMode::Open, FileAccess::Read, FileShare::Read);
+
+    // Empty files cannot be mapped:
+    const Int64 length = file->Length;
+    if (length == 0) {
+      delete file;
+      return gcnew MemoryStream(gcnew array<Byte>(0), false);
+    }
+
+    MemoryMappedFile^ mapping = MemoryMappedFile::CreateFromFile(
+      file, nullptr, 0, MemoryMappedFileAccess::Read, nullptr, HandleInheritability::None, false);
+    try {
+      // The view keeps the mapping alive, and the view stream of .NET reports a length
+      // rounded to the page size, hence the accessor:
+      return gcnew MappedFileStream(mapping->CreateViewAccessor(0, length, MemoryMappedFileAccess::Read), length);
+    }
+    finally {
+      delete mapping;
+    }
   }
 
   bool BaseScriptImpl::PerformBasicInstall() {
-    for (auto e: *g.SourceTree) {
-      if (!isFomodEntry(e)) {
-        auto ce = g.DestinationTree->copy(e, "", IFileTree::InsertPolicy::MERGE);
-        g.InstalledEntries[ce] = e;
-      }
+    // Nothing is copied until the destination tree is modified (or until the end of the
+    // installation), unless something has already been installed:
+    g.BasicInstallPending = true;
+    if (!g.DestinationTree->empty()) {
+      applyBasicInstall();
     }
     return true;
   }
 
-  bool BaseScriptImpl::InstallFileFromMod(String^ p_strFrom, String^ p_strTo) {
-    auto sourceEntry = g.SourceTree->find(to_qstring(p_strFrom));
-
-    if (!sourceEntry) {
-      log::warn("File '{}' not found in the archive.", to_wstring(p_strFrom));
+  /**
+   * @brief Install the given source entry at the given path in the destination tree.
+   *
+   * @param tree The destination tree.
+   * @param from Source path (for logging) and index of the entry to install.
+   * @param to Destination path of the entry.
+   *
+   * @return true if the entry was installed.
+   */
+  bool installFromMod(std::shared_ptr<IFileTree> const& tree, QString const& from, int index, QString const& to) {
+    if (index == SourceIndex::NONE) {
+      log::warn("File '{}' not found in the archive.", from);
       return false;
     }
 
-    if (auto ce = g.DestinationTree->copy(sourceEntry, to_qstring(p_strTo)); ce != nullptr) {
-      g.InstalledEntries[ce] = sourceEntry;
+    if (auto ce = tree->copy(g.Index.entry(index), to); ce != nullptr) {
+      registerCopy(ce, index, false);
       return true;
     }
 
     return false;
   }
 
-  array<String^>^ BaseScriptImpl::GetModFileList() {
-    // Cannot directly fill a, e.g., List<String^>^ because I cannot capture it:
-    std::vector<QString> paths;
-    g.SourceTree->walk([&](QString const& path, std::shared_ptr<const FileTreeEntry> entry) {
-      // Discard fomod folder:
-      if (isFomodEntry(entry)) {
-        return IFileTree::WalkReturn::SKIP;
+  bool BaseScriptImpl::InstallFileFromMod(String^ p_strFrom, String^ p_strTo) {
+    QString from = to_qstring(p_strFrom);
+    return installFromMod(destinationTree(), from, g.Index.find(from), to_qstring(p_strTo));
+  }
+
+  bool BaseScriptImpl::InstallFilesFromMod(array<String^>^ p_strFrom, array<String^>^ p_strTo) {
+    if (p_strFrom->Length != p_strTo->Length) {
+      throw gcnew ArgumentException("The source and destination arrays must have the same length.");
+    }
+
+    InstallBatch batch;
+    std::vector<int> indices;
+    for (int i = 0; i < p_strFrom->Length; ++i) {
+      QString from = to_qstring(p_strFrom[i]);
+      int index = g.Index.find(from);
+      if (index == SourceIndex::NONE) {
+        log::warn("File '{}' not found in the archive.", from);
+        continue;
+      }
+      batch.add(g.Index.entry(index), to_qstring(p_strTo[i]));
+      indices.push_back(index);
+    }
+
+    const int count = batch.apply(destinationTree(), [&](std::size_t item, std::shared_ptr<FileTreeEntry> const& copy) {
+      registerCopy(copy, indices[item], false);
+    });
+    return count == p_strFrom->Length;
+  }
+
+  int BaseScriptImpl::InstallFolderFromMod(String^ p_strFolder, String^ p_strTo, String^ p_strPattern, bool p_booRecursive) {
+    QString folder = to_qstring(p_strFolder);
+    int root = g.Index.find(folder);
+    if (root == SourceIndex::NONE || !g.Index.isDir(root)) {
+      log::warn("Folder '{}' not found in the archive.", folder);
+      return 0;
+    }
+
+    QString pattern = to_qstring(p_strPattern);
+    WildcardMatcher matcher(std::u16string_view(reinterpret_cast<const char16_t*>(pattern.utf16()), pattern.size()));
+
+    QString to = to_qstring(p_strTo);
+    if (!to.isEmpty() && !to.endsWith('/') && !to.endsWith('\\')) {
+      to += '/';
+    }
+
+    const int prefix = root == SourceIndex::ROOT ? 0 : g.Index.path(root).size() + 1;
+
+    InstallBatch batch;
+    std::vector<int> indices;
+    int i = root + 1;
+    while (i < g.Index.end(root)) {
+      // The fomod folder is never installed:
+      if (i == g.FomodIndex) {
+        i = g.Index.end(i);
+        continue;
       }
-      if (entry->isFile()) {
-        paths.push_back(path + entry->name());
+
+      QStringView name = g.Index.name(i);
+      if (g.Index.isFile(i) && matcher.matches(std::u16string_view(reinterpret_cast<const char16_t*>(name.data()), name.size()))) {
+        batch.add(g.Index.entry(i), to + g.Index.path(i).mid(prefix));
+        indices.push_back(i);
       }
-      return IFileTree::WalkReturn::CONTINUE;
-    }, "/");
 
-    // Convert to C#:
-    array<String^>^ result = gcnew array<String^>(paths.size());
-    for (std::size_t i = 0; i < paths.size(); ++i) {
-      result[i] = from_string(paths[i].toStdWString());
+      i = p_booRecursive ? i + 1 : g.Index.end(i);
     }
 
+    return batch.apply(destinationTree(), [&](std::size_t item, std::shared_ptr<FileTreeEntry> const& copy) {
+      registerCopy(copy, indices[item], false);
+    });
+  }
+
+  /**
+   * @brief Call the given function with the index of each file in the mod, excluding
+   * the fomod folder.
+   *
+   * @param recursive If false, only files at the root of the mod are visited.
+   * @param fn Function to call.
+   */
+  template <class Fn>
+  void forEachModFile(bool recursive, Fn&& fn) {
+    int i = SourceIndex::ROOT + 1;
+    while (i < g.Index.size()) {
+      // Discard fomod folder:
+      if (i == g.FomodIndex) {
+        i = g.Index.end(i);
+        continue;
+      }
+      if (g.Index.isFile(i)) {
+        fn(i);
+      }
+      i = recursive ? i + 1 : g.Index.end(i);
+    }
+  }
+
+  /**
+   * @brief Convert the paths of the given source entries to a managed array.
+   */
+  array<String^>^ toPathArray(std::vector<int> const& indices) {
+    array<String^>^ result = gcnew array<String^>(static_cast<int>(indices.size()));
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      result[static_cast<int>(i)] = from_string(g.Index.path(indices[i]));
+    }
     return result;
   }
 
+  array<String^>^ BaseScriptImpl::GetModFileList() {
+    // The archive does not change during the installation, so the list is computed once,
+    // and a copy is returned since scripts may modify it:
+    array<String^>^ files = g.ModFileList;
+    if (files == nullptr) {
+      std::vector<int> indices;
+      forEachModFile(true, [&](int i) { indices.push_back(i); });
+      files = toPathArray(indices);
+      g.ModFileList = files;
+    }
+
+    return safe_cast<array<String^>^>(files->Clone());
+  }
+
+  array<String^>^ BaseScriptImpl::GetModFileList(String^ p_strPattern, bool p_booRecursive) {
+    QString pattern = to_qstring(p_strPattern);
+    WildcardMatcher matcher(std::u16string_view(reinterpret_cast<const char16_t*>(pattern.utf16()), pattern.size()));
+
+    std::vector<int> indices;
+    forEachModFile(p_booRecursive, [&](int i) {
+      QStringView name = g.Index.name(i);
+      if (matcher.matches(std::u16string_view(reinterpret_cast<const char16_t*>(name.data()), name.size()))) {
+        indices.push_back(i);
+      }
+    });
+
+    return toPathArray(indices);
+  }
+
 
   /**
-   * @brief Extract the given entry.
-   *
-   * If the entry has already been extracted, the existing paths is returned.
+   * @brief Read the content of the given file, through the per-install cache.
    *
-   * @param entry The entry to extract.
+   * @param path Path to the file (extracted or from the data directory).
    *
-   * @return path to the temporary file corresponding to the entry.
+   * @return the content of the file, as a new array.
    */
-  QString extractFile(std::shared_ptr<const FileTreeEntry> entry) {
+  array<Byte>^ readFile(QString const& path) {
+    QByteArray const* data = g.Cache.find(path);
 
-    QString qPath;
-    if (auto it = g.ExtractedEntries.find(entry); it != g.ExtractedEntries.end()) {
-      qPath = it->second;
-    }
-    else {
-      qPath = g.InstallManager->extractFile(entry, true);
+    if (data == nullptr) {
+      QFile file(path);
 
-      if (qPath.isEmpty()) {
-        return QString();
+      // Let .NET report errors and handle files too large for the cache:
+      if (!file.open(QIODevice::ReadOnly) || !g.Cache.fits(file.size())) {
+        return File::ReadAllBytes(from_string(path));
+      }
+
+      // The managed array is built from the cached buffer, so the content is only copied
+      // once after being read:
+      data = g.Cache.insert(path, file.readAll());
+      if (data == nullptr) {
+        return File::ReadAllBytes(from_string(path));
       }
+    }
 
-      g.ExtractedEntries[entry] = qPath;
+    array<Byte>^ result = gcnew array<Byte>(data->size());
+    if (data->size() > 0) {
+      System::Runtime::InteropServices::Marshal::Copy(System::IntPtr(const_cast<char*>(data->constData())), result, 0, data->size());
     }
+    return result;
+  }
 
-    return qPath;
+  /**
+   * @brief Extract the given entry.
+   *
+   * If the entry has already been extracted (possibly in the background), the existing
+   * paths is returned.
+   *
+   * @param entry The entry to extract.
+   *
+   * @return path to the temporary file corresponding to the entry.
+   */
+  QString extractFile(std::shared_ptr<const FileTreeEntry> entry) {
+    return g.Extractor->extract(entry);
   }
 
   array<Byte>^ BaseScriptImpl::GetFileFromMod(String^ p_strFile) {
-    auto entry = g.SourceTree->find(to_qstring(p_strFile));
+    auto entry = g.Index.entry(g.Index.find(to_qstring(p_strFile)));
 
     if (!entry) {
       return gcnew array<Byte>(0);
@@ -268,33 +892,70 @@ namespace CSharp {
       return gcnew array<Byte>(0);
     }
 
-    String^ path = from_string(qPath.toStdWString());
-    return File::ReadAllBytes(path);
+    return readFile(qPath);
   }
 
-  QStringList getDataFiles(QString folder, QString pattern, bool allFolders) {
-    QStringList files = g_Organizer->findFiles(folder, [pattern](QString const& filepath) {
-      return QDir::match(pattern, QFileInfo(filepath).fileName());
-    });
-    if (allFolders) {
-      QStringList directories = g_Organizer->listDirectories(folder);
-      for (QString directory : directories) {
-        // MO2 does not like path with . or / (I think), so creating the path manually:
-        files.append(getDataFiles((folder.isEmpty() ? "" : folder + QDir::separator()) + directory, pattern, allFolders));
+  Stream^ BaseScriptImpl::OpenFileFromMod(String^ p_strFile) {
+    int index = g.Index.find(to_qstring(p_strFile));
+    if (index == SourceIndex::NONE || !g.Index.isFile(index)) {
+      return nullptr;
+    }
+
+    QString qPath = extractFile(g.Index.entry(index));
+    if (qPath.isEmpty()) {
+      return nullptr;
+    }
+
+    return openMappedFile(qPath);
+  }
+
+  array<Byte>^ BaseScriptImpl::GetFileRangeFromMod(String^ p_strFile, Int64 p_lngOffset, int p_intLength) {
+    int index = g.Index.find(to_qstring(p_strFile));
+    if (index == SourceIndex::NONE || !g.Index.isFile(index) || p_lngOffset < 0 || p_intLength <= 0) {
+      return gcnew array<Byte>(0);
+    }
+
+    QString qPath = extractFile(g.Index.entry(index));
+    if (qPath.isEmpty()) {
+      return gcnew array<Byte>(0);
+    }
+
+    FileStream^ file = gcnew FileStream(from_string(qPath), FileMode::Open, FileAccess::Read, FileShare::Read);
+    try {
+      const Int64 available = Math::Max(file->Length - p_lngOffset, Int64(0));
+      array<Byte>^ result = gcnew array<Byte>(static_cast<int>(Math::Min(Int64(p_intLength), available)));
+
+      file->Seek(p_lngOffset, SeekOrigin::Begin);
+      int read = 0;
+      while (read < result->Length) {
+        int n = file->Read(result, read, result->Length - read);
+        if (n == 0) {
+          Array::Resize(result, read);
+          break;
+        }
+        read += n;
       }
+      return result;
+    }
+    finally {
+      delete file;
     }
-    return files;
   }
 
   array<String^>^ BaseScriptImpl::GetExistingDataFileList(String^ p_strPath, String^ p_strPattern, bool p_booAllFolders) {
-    QStringList files = getDataFiles(to_qstring(p_strPath), to_qstring(p_strPattern), p_booAllFolders);
-    array<String^>^ result = gcnew array<String^>(files.size());
+    QString pattern = to_qstring(p_strPattern);
+    WildcardMatcher matcher(std::u16string_view(reinterpret_cast<const char16_t*>(pattern.utf16()), pattern.size()));
 
-    QDir modsDir(g_Organizer->modsPath());
+    QStringList files;
+    g.Data.forEachFile(to_qstring(p_strPath), p_booAllFolders, [&](DataIndex::Directory const& directory, DataIndex::File const& file) {
+      if (matcher.matches(std::u16string_view(reinterpret_cast<const char16_t*>(file.name.utf16()), file.name.size()))) {
+        files.append(directory.filePath(file));
+      }
+    });
+
+    array<String^>^ result = gcnew array<String^>(files.size());
     for (int i = 0; i < files.size(); ++i) {
-      // We need to trim the path to the actual folder containing the mod (did not find a better way):
-      QString rpath = modsDir.relativeFilePath(files[i]).replace("/", QDir::separator());
-      result[i] = from_string(rpath.mid(rpath.indexOf(QDir::separator()) + 1).toStdWString());
+      result[i] = from_string(files[i]);
     }
     return result;
   }
@@ -308,102 +969,108 @@ namespace CSharp {
    *
    * @param p_strPath Path to the file to lookup, relative to the data folder.
    *
-   * @return a path to an actual corresponding file, or a null pointer if the
+   * @return a path to an actual corresponding file, or an empty string if the
    *   file was not found.
    */
-  String^ getDataFilePath(String^ p_strPath) {
-    
+  QString getDataFilePath(QString const& qPath) {
+
     // Check if the file is in the output tree:
-    QString qPath = to_qstring(p_strPath);
-    if (auto e = g.DestinationTree->find(qPath); e != nullptr) {
-        
-      // Check if it's a created entry:
-      if (auto it = g.CreatedEntries.find(e); it != g.CreatedEntries.end()) {
-        return from_string(g.CreatedEntries[e]);
+    Origin origin;
+    if (auto type = findDestination(qPath, origin); type) {
+      if (type != FileTreeEntry::FILE) {
+        return QString();
       }
 
-      // Find the source entry - We need to check for parent:
-      std::shared_ptr<const FileTreeEntry> originalEntry;
-      if (auto it = g.InstalledEntries.find(e); it != g.InstalledEntries.end()) {
-        originalEntry = it->second;
-      }
-      else {
-        std::shared_ptr<const IFileTree> tree = e->parent();
-        decltype(tree) oTree = nullptr;
-        while (oTree == nullptr && tree != nullptr) {
-          auto it = g.InstalledEntries.find(tree);
-          if (it != g.InstalledEntries.end()) {
-            oTree = it->second->astree();
-          }
-          else {
-            tree = tree->parent();
-          }
-        }
-        originalEntry = oTree->find(e->pathFrom(tree));
+      QString path;
+      if (origin.type == Origin::CREATED) {
+        path = origin.path;
       }
-      QString path = extractFile(originalEntry);
-      if (path.isEmpty()) {
-        return nullptr;
+      else if (origin.type == Origin::ARCHIVE) {
+        path = extractFile(g.Index.entry(origin.index));
       }
-      return from_string(path);
+      return path;
     }
 
-    // Convert to path and normalize separator:
-    auto path = std::filesystem::path(qPath.toStdWString()).make_preferred();
-    QStringList paths = g_Organizer->findFiles(ToQString(path.parent_path().native()), [name = ToQString(path.filename())](QString const& filepath) {
-      return QFileInfo(filepath).fileName().compare(name, Qt::CaseInsensitive) == 0;
-    });
-
-    if (paths.isEmpty()) {
-      return nullptr;
+    // Otherwise look in the data directory:
+    auto file = g.Data.file(qPath);
+    if (file == nullptr) {
+      return QString();
     }
 
-    return from_string(paths[0]);
+    return file->filePath;
   }
 
   bool BaseScriptImpl::DataFileExists(String^ p_strPath) {
-    return getDataFilePath(p_strPath) != nullptr;
+    // Only metadata is needed here, the file itself is only extracted if the script
+    // actually reads it with GetExistingDataFile:
+    QString qPath = to_qstring(p_strPath);
+    Origin origin;
+    if (auto type = findDestination(qPath, origin); type) {
+      return type == FileTreeEntry::FILE;
+    }
+    return g.Data.file(qPath) != nullptr;
   }
 
   array<Byte>^ BaseScriptImpl::GetExistingDataFile(String^ p_strPath) {
 
-    // Convert to path and normalize separator:
-    String^ datapath = getDataFilePath(p_strPath);
+    QString datapath = getDataFilePath(to_qstring(p_strPath));
+
+    if (datapath.isEmpty()) {
+      return nullptr;
+    }
+
+    return readFile(datapath);
+  }
+
+  Stream^ BaseScriptImpl::OpenExistingDataFile(String^ p_strPath) {
+    QString datapath = getDataFilePath(to_qstring(p_strPath));
 
-    if (datapath == nullptr) {
+    if (datapath.isEmpty()) {
       return nullptr;
     }
 
-    // Read the first file (should be only one):
-    return File::ReadAllBytes(datapath);
+    return openMappedFile(datapath);
   }
 
   bool BaseScriptImpl::GenerateDataFile(String^ p_strPath, array<Byte>^ p_bteData) {
 
     // Check if we already have created an entry for this:
     QString qPath = to_qstring(p_strPath);
-    auto entry = g.DestinationTree->find(qPath);
+    auto tree = destinationTree();
+    auto entry = tree->find(qPath);
 
     QString qAbsPath;
-    // If the entry is in the list of created files (note: if the entry does not exist,
-    // find return a nullptr, which is never in g.CreatedEntries).
-    if (auto it = g.CreatedEntries.find(entry); it != g.CreatedEntries.end()) {
-      qAbsPath = g.CreatedEntries.at(entry);
+    // If the entry has been created by the script (note: if the entry does not exist,
+    // find return a nullptr, which is never in g.Origins).
+    if (auto it = g.Origins.find(entry); it != g.Origins.end() && it->second.type == Origin::CREATED) {
+      qAbsPath = it->second.path;
     }
     // Otherwize: Create the entry and the temporary file:
     else {
-      auto entry = g.DestinationTree->addFile(qPath, true);
-      qAbsPath = g.InstallManager->createFile(entry);
+      auto created = tree->addFile(qPath, true);
+      qAbsPath = g.InstallManager->createFile(created);
       if (qAbsPath.isEmpty()) {
         // Remove the entry from the tree:
-        entry->detach();
-        return false;
+        created->detach();
+      }
+      else {
+        // Store the created entry:
+        g.Origins[created] = { Origin::CREATED, SourceIndex::NONE, qAbsPath };
       }
 
-      // Store the created entry:
-      g.CreatedEntries[entry] = qAbsPath;
+      // The existing entry (if any) has been replaced:
+      if (entry != nullptr) {
+        dropDetachedOrigins();
+      }
+
+      if (qAbsPath.isEmpty()) {
+        return false;
+      }
     }
 
+    // The content of the file changes:
+    g.Cache.remove(qAbsPath);
+
     String^ absPath = from_string(qAbsPath);
     File::WriteAllBytes(absPath, p_bteData);
     return true;
@@ -492,6 +1159,35 @@ namespace CSharp {
   }
 
 
+  /**
+   * @brief Event filter that adds the preview of an option to its tooltip the first time
+   * the tooltip is shown, so that previews are only extracted when needed.
+   */
+  class PreviewToolTip : public QObject {
+  public:
+
+    PreviewToolTip(int index, QString description, QObject* parent) :
+      QObject(parent), m_Index(index), m_Description(std::move(description)) { }
+
+    bool eventFilter(QObject* watched, QEvent* event) override {
+      if (event->type() == QEvent::ToolTip && m_Index != SourceIndex::NONE) {
+        QString previewPath = extractFile(g.Index.entry(m_Index));
+        m_Index = SourceIndex::NONE;
+        if (!previewPath.isEmpty()) {
+          // The tooltip becomes rich text, so the description must be converted:
+          QString toolTip = m_Description.isEmpty() ? QString() : Qt::convertFromPlainText(m_Description);
+          toolTip += QString("<p><img src=\"%1\" width=\"300\"/></p>").arg(previewPath.toHtmlEscaped());
+          static_cast<QWidget*>(watched)->setToolTip(toolTip);
+        }
+      }
+      return false;
+    }
+
+  private:
+    int m_Index;
+    QString m_Description;
+  };
+
   array<int>^ BaseScriptImpl::Select(array<SelectOption^>^ p_sopOptions, String^ p_strTitle, bool p_booSelectMany) {
     using namespace System::Collections::Generic;
 
@@ -519,8 +1215,16 @@ namespace CSharp {
         btn = new QRadioButton(to_qstring(opt->Item), inputDialog);
       }
 
-      if (!String::IsNullOrEmpty(opt->Desc)) {
-        btn->setToolTip(to_qstring(opt->Desc));
+      QString description = String::IsNullOrEmpty(opt->Desc) ? QString() : to_qstring(opt->Desc);
+      if (!description.isEmpty()) {
+        btn->setToolTip(description);
+      }
+
+      if (!String::IsNullOrEmpty(opt->Preview)) {
+        int index = g.Index.find(to_qstring(opt->Preview));
+        if (index != SourceIndex::NONE && g.Index.isFile(index)) {
+          btn->installEventFilter(new PreviewToolTip(index, description, btn));
+        }
       }
 
       layout->addWidget(btn);
@@ -579,7 +1283,7 @@ namespace CSharp {
       return nullptr;
     }
 
-    return gcnew Version(msclr::interop::marshal_as<String^>(scriptExtender->getExtenderVersion().toStdString()));
+    return gcnew Version(from_string(scriptExtender->getExtenderVersion()));
   }
 
   bool BaseScriptImpl::ScriptExtenderPresent() {
@@ -588,36 +1292,135 @@ namespace CSharp {
   }
 
   // Plugins:
-  array<String^>^ BaseScriptImpl::GetAllPlugins() {
-    QStringList names = g_Organizer->pluginList()->pluginNames();
-    array<String^>^ result = gcnew array<String^>(names.size());
-    for (int i = 0; i < names.size(); ++i) {
-      result[i] = from_string(names[i].toStdString());
+  /**
+   * @brief Retrieve the plugin list, as it was the first time it was requested during
+   * this installation.
+   */
+  PluginSnapshot& plugins() {
+    if (g.Plugins == nullptr) {
+      auto pluginList = g_Organizer->pluginList();
+
+      // Sort the plugins by load order:
+      std::vector<std::pair<int, QString>> plugins;
+      for (QString const& name : pluginList->pluginNames()) {
+        plugins.emplace_back(pluginList->priority(name), name);
+      }
+      std::stable_sort(plugins.begin(), plugins.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+
+      auto snapshot = std::make_unique<PluginSnapshot>();
+      snapshot->Names.reserve(static_cast<int>(plugins.size()));
+      snapshot->States.reserve(plugins.size());
+      snapshot->Priorities.reserve(plugins.size());
+      for (auto& p : plugins) {
+        snapshot->Indices.insert(p.second.toCaseFolded(), snapshot->Names.size());
+        snapshot->Names.append(p.second);
+        snapshot->States.push_back(pluginList->state(p.second));
+        snapshot->Priorities.push_back(p.first);
+      }
+      g.Plugins = std::move(snapshot);
     }
-    return result;
+    return *g.Plugins;
   }
 
-  array<String^>^ BaseScriptImpl::GetActivePlugins() {
-    auto pluginList = g_Organizer->pluginList();
-    QStringList names = pluginList->pluginNames();
-    QStringList activeNames;
-    for (auto& name : names) {
-      if (pluginList->state(name) == IPluginList::STATE_ACTIVE) {
-        activeNames.append(name);
+  /**
+   * @brief Convert the plugins for which the given predicate is true to a managed array.
+   */
+  template <class Fn>
+  array<String^>^ toPluginArray(PluginSnapshot const& snapshot, Fn&& fn) {
+    std::vector<int> indices;
+    for (int i = 0; i < snapshot.Names.size(); ++i) {
+      if (fn(i)) {
+        indices.push_back(i);
       }
     }
-    array<String^>^ result = gcnew array<String^>(activeNames.size());
-    for (int i = 0; i < activeNames.size(); ++i) {
-      result[i] = from_string(activeNames[i].toStdString());
+
+    array<String^>^ result = gcnew array<String^>(static_cast<int>(indices.size()));
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      result[static_cast<int>(i)] = from_string(snapshot.Names[indices[i]]);
     }
     return result;
   }
+
+  array<String^>^ BaseScriptImpl::GetAllPlugins() {
+    // Once the script has modified the load order, the modified one is returned, so that
+    // the indices given to SetLoadOrder() always refer to the last returned list:
+    if (g.Journal != nullptr) {
+      QStringList const& order = g.Journal->loadOrder();
+      array<String^>^ result = gcnew array<String^>(order.size());
+      for (int i = 0; i < order.size(); ++i) {
+        result[i] = from_string(order[i]);
+      }
+      return result;
+    }
+
+    PluginSnapshot& snapshot = plugins();
+    array<String^>^ result = snapshot.AllPlugins;
+    if (result == nullptr) {
+      result = toPluginArray(snapshot, [](int) { return true; });
+      snapshot.AllPlugins = result;
+    }
+    return safe_cast<array<String^>^>(result->Clone());
+  }
+
+  array<String^>^ BaseScriptImpl::GetActivePlugins() {
+    PluginSnapshot& snapshot = plugins();
+    array<String^>^ result = snapshot.ActivePlugins;
+    if (result == nullptr) {
+      result = toPluginArray(snapshot, [&](int i) { return snapshot.States[i] == IPluginList::STATE_ACTIVE; });
+      snapshot.ActivePlugins = result;
+    }
+    return safe_cast<array<String^>^>(result->Clone());
+  }
+
+  /**
+   * @brief Retrieve the journal of operations on the plugin list, creating it if needed.
+   */
+  PluginJournal& journal() {
+    if (g.Journal == nullptr) {
+      g.Journal = std::make_unique<PluginJournal>(plugins().Names);
+    }
+    return *g.Journal;
+  }
+
+  void BaseScriptImpl::SetPluginActivation(String^ p_strPluginPath, bool p_booActivate) {
+    journal().setActive(QFileInfo(to_qstring(p_strPluginPath)).fileName(), p_booActivate);
+  }
+
+  void BaseScriptImpl::SetPluginOrderIndex(String^ p_strPlugin, int p_intNewIndex) {
+    journal().setIndex(QFileInfo(to_qstring(p_strPlugin)).fileName(), p_intNewIndex);
+  }
+
+  void BaseScriptImpl::SetLoadOrder(array<int>^ p_intPlugins) {
+    std::vector<int> indices(p_intPlugins->Length);
+    for (int i = 0; i < p_intPlugins->Length; ++i) {
+      indices[i] = p_intPlugins[i];
+    }
+    if (!journal().setLoadOrder(indices)) {
+      log::warn("SetLoadOrder: invalid load order, ignoring.");
+    }
+  }
+
+  void BaseScriptImpl::SetLoadOrder(array<int>^ p_intPlugins, int p_intPosition) {
+    std::vector<int> indices(p_intPlugins->Length);
+    for (int i = 0; i < p_intPlugins->Length; ++i) {
+      indices[i] = p_intPlugins[i];
+    }
+    if (!journal().moveTo(std::move(indices), p_intPosition)) {
+      log::warn("SetLoadOrder: invalid plugin index, ignoring.");
+    }
+  }
+
+  bool BaseScriptImpl::IsPluginActive(String^ p_strPlugin) {
+    PluginSnapshot& snapshot = plugins();
+    int index = snapshot.Indices.value(to_qstring(p_strPlugin).toCaseFolded(), -1);
+    return index != -1 && snapshot.States[index] == IPluginList::STATE_ACTIVE;
+  }
   
   // INIs:
   String^ BaseScriptImpl::GetIniString(String^ settingsFileName, String^ section, String^ key) {
 
     // Check if we have already set this within this installation:
-    auto fIt = g.Settings.find(to_qstring(settingsFileName));
+    auto fIt = g.Settings.find(gameIniFile(to_qstring(settingsFileName)));
     if (fIt != g.Settings.end()) {
       QString value = fIt->second.value(to_qstring(section), to_qstring(key));
       if (!value.isEmpty()) {
@@ -626,28 +1429,17 @@ namespace CSharp {
     }
 
     // Otherwize, look-up the file:
-    QDir path(g_Organizer->profilePath());
-    if (!g_Organizer->profile()->localSettingsEnabled()) {
-      path = QDir(g_Organizer->managedGame()->documentsDirectory());
-    }
-
-    QSettings settings(path.filePath(to_qstring(settingsFileName)), QSettings::IniFormat);
-    
-    if (settings.status() != QSettings::NoError) {
+    IniTable const* table = iniTable(to_qstring(settingsFileName));
+    if (table == nullptr) {
       return nullptr;
     }
 
-    QString name = to_qstring(section + "/" + key);
-    if (section->Equals("General", System::StringComparison::CurrentCultureIgnoreCase)) {
-      name = to_qstring(key);
-    }
-
-    QVariant value = settings.value(name);
-    if (!value.isValid()) {
+    auto it = table->Values.find(iniKey(to_qstring(section), to_qstring(key)));
+    if (it == table->Values.end()) {
       return nullptr;
     }
 
-    return from_string(value.toString().toStdString());
+    return from_string(it.value());
   } 
 
   int BaseScriptImpl::GetIniInt(String^ settingsFileName, String^ section, String^ key) {
@@ -656,18 +1448,12 @@ namespace CSharp {
 
   bool BaseScriptImpl::EditIni(String^ p_strSettingsFileName, String^ p_strSection, String^ p_strKey, String^ p_strValue) {
     // Check that the file is supported:
-    bool iniFound = false;
-    for (auto ini : g_Organizer->managedGame()->iniFiles()) {
-      if (ini.compare(to_qstring(p_strSettingsFileName), Qt::CaseInsensitive) == 0) {
-        iniFound = true;
-      }
-    }
-
-    if (!iniFound) {
+    QString ini = gameIniFile(to_qstring(p_strSettingsFileName));
+    if (ini.isEmpty()) {
       return false;
     }
 
-    g.Settings[to_qstring(p_strSettingsFileName)].setValue(to_qstring(p_strSection), to_qstring(p_strKey), to_qstring(p_strValue));
+    g.Settings[ini].setValue(to_qstring(p_strSection), to_qstring(p_strKey), to_qstring(p_strValue));
     return true;
   }
 
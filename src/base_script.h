@@ -117,6 +117,28 @@ namespace CSharp {
     /// <returns><c>true</c> if the file was written; <c>false</c> otherwise.</returns>
     static bool InstallFileFromMod(String^ p_strFrom, String^ p_strTo);
 
+    /// <summary>
+    /// Installs the specified files from the mod to the specified locations on the file system.
+    /// </summary>
+    /// <remarks>
+    /// This is equivalent to calling <see cref="InstallFileFromMod(string, string)"/> for each
+    /// pair of paths, but much faster for large number of files.
+    /// </remarks>
+    /// <param name="p_strFrom">The paths of the files in the mod to install.</param>
+    /// <param name="p_strTo">The paths on the file system where the files are to be created.</param>
+    /// <returns><c>true</c> if all the files were written; <c>false</c> otherwise.</returns>
+    static bool InstallFilesFromMod(array<String^>^ p_strFrom, array<String^>^ p_strTo);
+
+    /// <summary>
+    /// Installs the files of the specified folder of the mod to the specified location on the file system.
+    /// </summary>
+    /// <param name="p_strFolder">The path of the folder in the mod to install.</param>
+    /// <param name="p_strTo">The path on the file system where the content of the folder is to be created.</param>
+    /// <param name="p_strPattern">The pattern against which to filter the file names.</param>
+    /// <param name="p_booRecursive">Whether or not to install files in subdirectories.</param>
+    /// <returns>The number of files written.</returns>
+    static int InstallFolderFromMod(String^ p_strFolder, String^ p_strTo, String^ p_strPattern, bool p_booRecursive);
+
     /// <summary>
     /// Installs the speified file from the mod to the file system.
     /// </summary>
@@ -151,6 +173,14 @@ namespace CSharp {
     /// <returns>The list of files in the mod.</returns>
     static array<String^>^ GetModFileList();
 
+    /// <summary>
+    /// Retrieves a filtered list of files in the mod.
+    /// </summary>
+    /// <param name="p_strPattern">The pattern against which to filter the file names.</param>
+    /// <param name="p_booRecursive">Whether or not to include files in subdirectories.</param>
+    /// <returns>The list of files in the mod matching the pattern.</returns>
+    static array<String^>^ GetModFileList(String^ p_strPattern, bool p_booRecursive);
+
     /// <summary>
     /// Retrieves the list of files in the mod.
     /// </summary>
@@ -175,6 +205,27 @@ namespace CSharp {
         return GetFileFromMod(p_strFile);
     }
 
+    /// <summary>
+    /// Opens the specified file from the mod for reading.
+    /// </summary>
+    /// <remarks>
+    /// The file is memory-mapped, so this should be preferred to <see cref="GetFileFromMod(string)"/>
+    /// for large files that are only partially read. The stream must be disposed by the caller.
+    /// </remarks>
+    /// <param name="p_strFile">The file to open.</param>
+    /// <returns>A read-only stream over the file, or <c>null</c> if the file does not exist.</returns>
+    static IO::Stream^ OpenFileFromMod(String^ p_strFile);
+
+    /// <summary>
+    /// Retrieves part of the specified file from the mod.
+    /// </summary>
+    /// <param name="p_strFile">The file to retrieve.</param>
+    /// <param name="p_lngOffset">The offset of the first byte to retrieve.</param>
+    /// <param name="p_intLength">The maximum number of bytes to retrieve.</param>
+    /// <returns>The requested file data, which is shorter than <paramref name="p_intLength"/>
+    /// if the end of the file is reached.</returns>
+    static array<Byte>^ GetFileRangeFromMod(String^ p_strFile, Int64 p_lngOffset, int p_intLength);
+
     /// <summary>
     /// Gets a filtered list of all files in a user's Data directory.
     /// </summary>
@@ -199,6 +250,17 @@ namespace CSharp {
     /// <returns>The specified file, or <c>null</c> if the file does not exist.</returns>
     static array<Byte>^ GetExistingDataFile(String^ p_strPath);
 
+    /// <summary>
+    /// Opens the specified file from the user's Data directory for reading.
+    /// </summary>
+    /// <remarks>
+    /// The file is memory-mapped, so this should be preferred to <see cref="GetExistingDataFile(string)"/>
+    /// for large files that are only partially read. The stream must be disposed by the caller.
+    /// </remarks>
+    /// <param name="p_strPath">The path of the file to open.</param>
+    /// <returns>A read-only stream over the file, or <c>null</c> if the file does not exist.</returns>
+    static IO::Stream^ OpenExistingDataFile(String^ p_strPath);
+
     /// <summary>
     /// Writes the file represented by the given byte array to the given path.
     /// </summary>
@@ -389,6 +451,11 @@ namespace CSharp {
     /// <summary>
     /// Gets a list of all install plugins.
     /// </summary>
+    /// <remarks>
+    /// The plugins are in load order, including the changes made with
+    /// <see cref="SetPluginOrderIndex"/> and <see cref="SetLoadOrder"/>
+    /// during this installation.
+    /// </remarks>
     /// <returns>A list of all install plugins.</returns>
     static array<String^>^ GetAllPlugins();
 
@@ -398,36 +465,49 @@ namespace CSharp {
     /// <returns>A list of currently active plugins.</returns>
     static array<String^>^ GetActivePlugins();
 
+    /// <summary>
+    /// Determines if the specified plugin is active.
+    /// </summary>
+    /// <remarks>
+    /// This is faster than looking the plugin up in <see cref="GetActivePlugins()"/>.
+    /// </remarks>
+    /// <param name="p_strPlugin">The name of the plugin.</param>
+    /// <returns><c>true</c> if the plugin is active; <c>false</c> otherwise.</returns>
+    static bool IsPluginActive(String^ p_strPlugin);
+
     /// <summary>
     /// Sets the activated status of a plugin (i.e., and esp or esm file).
     /// </summary>
+    /// <remarks>
+    /// The change is applied to the plugin list after the installation, once the plugins
+    /// of the mod are in the plugin list.
+    /// </remarks>
     /// <param name="p_strPluginPath">The path to the plugin to activate or deactivate.</param>
     /// <param name="p_booActivate">Whether to activate the plugin.</param>
-    static void SetPluginActivation(String^ p_strPluginPath, bool p_booActivate) {
-      // throw gcnew NotImplementedException("SetPluginActivation");
-    }
+    static void SetPluginActivation(String^ p_strPluginPath, bool p_booActivate);
 
     /// <summary>
     /// Sets the load order of the specifid plugin.
     /// </summary>
+    /// <remarks>
+    /// The change is applied to the plugin list after the installation, once the plugins
+    /// of the mod are in the plugin list.
+    /// </remarks>
     /// <param name="p_strPlugin">The path to the plugin file whose load order is to be set.</param>
     /// <param name="p_intNewIndex">The new load order index of the plugin.</param>
-    static void SetPluginOrderIndex(String^ p_strPlugin, int p_intNewIndex) {
-      // throw gcnew NotImplementedException("SetPluginOrderIndex");
-    }
+    static void SetPluginOrderIndex(String^ p_strPlugin, int p_intNewIndex);
 
     /// <summary>
     /// Sets the load order of the plugins.
     /// </summary>
     /// <remarks>
     /// Each plugin will be moved from its current index to its indices' position
-    /// in <paramref name="p_intPlugins"/>.
+    /// in <paramref name="p_intPlugins"/>. The new load order is applied to the plugin list
+    /// after the installation.
     /// </remarks>
     /// <param name="p_intPlugins">The new load order of the plugins. Each entry in this array
     /// contains the current index of a plugin. This array must contain all current indices.</param>
-    static void SetLoadOrder(array<int>^ p_intPlugins) {
-      // throw gcnew NotImplementedException("SetLoadOrder");
-    }
+    static void SetLoadOrder(array<int>^ p_intPlugins);
 
     /// <summary>
     /// Moves the specified plugins to the given position in the load order.
@@ -436,15 +516,14 @@ namespace CSharp {
     /// Note that the order of the given list of plugins is not maintained. They are re-ordered
     /// to be in the same order as they are in the before-operation load order. This, I think,
     /// is somewhat counter-intuitive and may change, though likely not so as to not break
-    /// backwards compatibility.
+    /// backwards compatibility. The new load order is applied to the plugin list after the
+    /// installation.
     /// </remarks>
     /// <param name="p_intPlugins">The list of plugins to move to the given position in the
     /// load order. Each entry in this array contains the current index of a plugin.</param>
     /// <param name="p_intPosition">The position in the load order to which to move the specified
     /// plugins.</param>
-    static void SetLoadOrder(array<int>^ p_intPlugins, int p_intPosition) {
-      // throw gcnew NotImplementedException("SetLoadOrder");
-    }
+    static void SetLoadOrder(array<int>^ p_intPlugins, int p_intPosition);
 
     /// <summary>
     /// Retrieves the specified settings value as a string.
@@ -539,6 +618,11 @@ namespace CSharp {
    * @brief Post-install script.
    */
   MOBase::IPluginInstaller::EInstallResult postInstall(std::shared_ptr<MOBase::IFileTree>& tree);
+
+  /**
+   * @brief Clear the per-install state (stopping background extraction).
+   */
+  void endInstall();
 }
 
 // BaseScript cannot be in a namespace:
@@ -1,94 +1,32 @@
 #include "csharp_interface.h"
 
-#include <fstream>
-#include <sstream>
-#include <regex>
+#include <string>
+#include <string_view>
+
+#include <vcclr.h>
 
 #include "log.h"
 
 #include "csharp_utils.h"
 #include "base_script.h"
+#include "script_compiler.h"
+#include "script_rewriter.h"
 
 #using <System.dll>
 
 using namespace MOBase;
 
-/**
- * This is a assembly resolve handler that does only one thing: returns the assembly 
- * containing BaseScript (usually the DLL) when requested.
- *
- * I don't know why this must be done manually... But I did not find any better solution.
- */
-System::Reflection::Assembly^ currentDomain_AssemblyResolve(System::Object^, System::ResolveEventArgs^ args)
-{
-  using namespace System::Reflection;
-
-  try {
-    Assembly^ baseScriptAssembly = System::Reflection::Assembly::GetAssembly(BaseScript::typeid);
-    if (args->Name->Equals(baseScriptAssembly->FullName)) {
-      return baseScriptAssembly;
-    }
-  }
-  catch (...)
-  {
-  }
-
-  return nullptr;
-}
-
-IPluginInstaller::EInstallResult executeScript(System::String^ script) {
+IPluginInstaller::EInstallResult executeScript(System::Reflection::Assembly^ assembly) {
 
   using namespace System;
-  using namespace System::CodeDom;
-  using namespace System::CodeDom::Compiler;
-  using namespace System::Collections::Generic;
-
-  AppDomain^ currentDomain = AppDomain::CurrentDomain;
-  currentDomain->AssemblyResolve += gcnew ResolveEventHandler(currentDomain_AssemblyResolve);
-
-  // From Nexus-Mods/fomod-installer:
-  Dictionary<String^, String^>^ dicOptions = gcnew Dictionary<String^, String^>(10);
-  dicOptions->Add("CompilerVersion", "v4.0");
-
-  // List of assemblies (including BaseScript) - From Nexus-Mods/fomod-installer:
-  array<String^>^ referenceAssemblies = {
-    "System.dll",
-    "System.Runtime.dll",
-    "System.Drawing.dll",
-    "System.Windows.Forms.dll",
-    "System.Xml.dll",
-    System::Reflection::Assembly::GetAssembly(BaseScript::typeid)->Location
-  };
-
-  CompilerParameters^ cp = gcnew CompilerParameters(referenceAssemblies);
-  cp->GenerateExecutable = false;
-  cp->IncludeDebugInformation = false;
-  cp->GenerateInMemory = true;
-  cp->TreatWarningsAsErrors = false;
-  CodeDomProvider^ provider = CodeDomProvider::CreateProvider("CSharp", dicOptions);
-
-  // Compile the script
-  auto result = provider->CompileAssemblyFromSource(cp, script);
-
-  int errorCount = 0;
-  CompilerErrorCollection^ errors = result->Errors;
-  for each (CompilerError^ error in result->Errors) {
-    if (error->IsWarning) {
-      log::error("C# [{}]: {}", error->Line, CSharp::to_string(error->ErrorText));
-    }
-    else {
-      log::warn("C# [{}]: {}", error->Line, CSharp::to_string(error->ErrorText));
-    }
-    ++errorCount;
-  }
 
-  if (errorCount > 0) {
+  if (assembly == nullptr) {
     return IPluginInstaller::EInstallResult::RESULT_FAILED;
   }
 
   // Execute the script:
   try {
-    auto scriptClass = result->CompiledAssembly->GetType("Script");
+    auto scriptClass = assembly->GetType("Script");
     BaseScript^ scriptObject = (BaseScript^)System::Activator::CreateInstance(scriptClass);
     auto onActivateMethod = scriptObject->GetType()->GetMethod("OnActivate");
 
@@ -108,49 +46,118 @@ IPluginInstaller::EInstallResult executeScript(System::String^ script) {
 
 namespace CSharp {
 
-  IPluginInstaller::EInstallResult executeCSharpScript(QString scriptPath, std::shared_ptr<IFileTree> &tree) {
-
-    using namespace System;
-    using namespace System::IO;
-    using namespace System::Text::RegularExpressions;
-
-    // Note: Using C# stuff here to mimicate NMM since there are some encoding issues, and
-    // some regex do not work in C++:
-    array<Byte>^ scriptBytes = File::ReadAllBytes(from_string(scriptPath.toStdWString()));
-    
-    // Read the script (using C# to "auto-detect" encoding in a C# way):
-    String^ script;
-    {
-      auto memoryStream = gcnew MemoryStream(scriptBytes);
-      auto reader = gcnew StreamReader(memoryStream, true);
-    
-      script = reader->ReadToEnd();
-
-      reader->Close();
-      memoryStream->Close();
-
-      delete reader;
-      delete memoryStream;
+  using namespace System;
+  using namespace System::Threading;
+  using namespace System::Threading::Tasks;
+
+  /**
+   * Rewrites and compiles a script. This is run on a worker thread while the user
+   * is looking at the pre-installation dialog.
+   */
+  ref class ScriptPreparation {
+  public:
+
+    ScriptPreparation(String^ script, CancellationToken token) :
+      m_Script(script), m_Token(token) { }
+
+    Reflection::Assembly^ Run() {
+      try {
+        if (m_Token.IsCancellationRequested) {
+          return nullptr;
+        }
+
+        String^ script = preprocess(m_Script);
+
+        if (m_Token.IsCancellationRequested) {
+          return nullptr;
+        }
+
+        return compileScript(script);
+      }
+      catch (Exception^ ex) {
+        log::error("C# ({}): {}", to_string(ex->GetType()->FullName), to_string(ex->Message));
+        return nullptr;
+      }
     }
 
+  private:
 
-    Regex ^regScriptClass = gcnew Regex(R"re((class\s+Script\s*:.*?)(\S*BaseScript))re");
-    Regex ^regFommUsing = gcnew Regex(R"re(\s*using\s*fomm.Scripting\s*;)re");
+    /**
+     * @brief Rewrite the script so that it uses our BaseScript.
+     */
+    static String^ preprocess(String^ script) {
+      pin_ptr<const wchar_t> chars = PtrToStringChars(script);
+      std::wstring code = rewriteScript(std::wstring_view(chars, script->Length));
+      return gcnew String(code.data(), 0, static_cast<int>(code.size()));
+    }
 
-    String^ strBaseScriptClassName = regScriptClass->Match(script)->Groups[2]->ToString();
-    Regex^ regOtherScriptClasses = gcnew Regex(String::Format(R"re((class\s+\S+\s*:.*?)(?<!\w){0})re", strBaseScriptClassName));
-    String^ strCode = script;
-    strCode = regScriptClass->Replace(strCode, "$1BaseScript");
-    strCode = regOtherScriptClasses->Replace(strCode, "$1BaseScript");
-    strCode = regFommUsing->Replace(strCode, "");
+    String^ m_Script;
+    CancellationToken m_Token;
+  };
 
-    auto result = executeScript(strCode);
+  // The script being prepared, if any:
+  static gcroot<Task<Reflection::Assembly^>^> g_PreparedScript;
+  static gcroot<CancellationTokenSource^> g_PreparedScriptCancellation;
+
+  /**
+   * @brief Cancel the preparation of the current script, if any.
+   */
+  void cancelCSharpScript() {
+    CancellationTokenSource^ cancellation = g_PreparedScriptCancellation;
+    if (cancellation != nullptr) {
+      cancellation->Cancel();
+    }
 
-    if (result != IPluginInstaller::EInstallResult::RESULT_SUCCESS) {
-      return result;
+    // The task is not waited for, it will stop at the next check or finish
+    // compiling in the background:
+    g_PreparedScript = nullptr;
+    g_PreparedScriptCancellation = nullptr;
+  }
+
+  void prepareCSharpScript(QString const& script) {
+    cancelCSharpScript();
+
+    CancellationTokenSource^ cancellation = gcnew CancellationTokenSource();
+    ScriptPreparation^ preparation = gcnew ScriptPreparation(from_string(script), cancellation->Token);
+
+    g_PreparedScriptCancellation = cancellation;
+    g_PreparedScript = Task::Run<Reflection::Assembly^>(gcnew Func<Reflection::Assembly^>(preparation, &ScriptPreparation::Run), cancellation->Token);
+  }
+
+  void cancelInstall() {
+    cancelCSharpScript();
+    endInstall();
+  }
+
+  IPluginInstaller::EInstallResult executeCSharpScript(std::shared_ptr<IFileTree> &tree) {
+
+    Task<Reflection::Assembly^>^ task = g_PreparedScript;
+    if (task == nullptr) {
+      log::error("C#: no script was prepared for this installation.");
+      endInstall();
+      return IPluginInstaller::EInstallResult::RESULT_FAILED;
     }
 
-    return postInstall(tree);
+    // Wait for the compilation to finish:
+    Reflection::Assembly^ assembly = nullptr;
+    try {
+      assembly = task->Result;
+    }
+    catch (AggregateException^ ex) {
+      log::error("C# ({}): {}", to_string(ex->GetType()->FullName), to_string(ex->InnerException != nullptr ? ex->InnerException->Message : ex->Message));
+    }
+
+    g_PreparedScript = nullptr;
+    g_PreparedScriptCancellation = nullptr;
+
+    auto result = executeScript(assembly);
+
+    if (result == IPluginInstaller::EInstallResult::RESULT_SUCCESS) {
+      result = postInstall(tree);
+    }
+
+    endInstall();
+    return result;
   }
 
-}
\ No newline at end of file
+}
@@ -13,28 +13,47 @@ namespace CSharp {
   /**
    * @brief Initialize the C# interface before starting an installation.
    *
+   * This also starts extracting, in the background, the files the script is likely
+   * to need.
+   *
    * @param installer The FOMOD C# installer.
    * @param manager The installation manager from the installer.
    * @param parentWidget The parent widget from the installer.
    * @param tree The archive tree.
    * @param extractedEntries A map from extracted entries to their extracted path.
+   * @param script The source of the script.
    */
   void beforeInstall(
     MOBase::IPlugin const* installer,
     MOBase::IInstallationManager* manager, 
     QWidget* parentWidget, 
     std::shared_ptr<MOBase::IFileTree> tree, 
-    std::map<std::shared_ptr<const MOBase::FileTreeEntry>, QString> extractedEntries);
+    std::map<std::shared_ptr<const MOBase::FileTreeEntry>, QString> extractedEntries,
+    QString const& script);
+
+  /**
+   * @brief Start compiling a script in the background.
+   *
+   * The result is awaited by executeCSharpScript(), or discarded by cancelInstall().
+   *
+   * @param script The source of the script to prepare.
+   */
+  void prepareCSharpScript(QString const& script);
+
+  /**
+   * @brief Cancel the current installation, stopping the preparation of the script and
+   * the background extraction.
+   */
+  void cancelInstall();
 
   /**
-   * @brief Clear the C# interface after an installation.
+   * @brief Execute the prepared script and clear the C# interface after an installation.
    *
-   * @param scriptPath Path to the script to execute.
    * @param tree Reference where the final tree will be stored (in case of success.
    *
    * @return the installation result after performing post-installation.
    */
-  MOBase::IPluginInstaller::EInstallResult executeCSharpScript(QString scriptPath, std::shared_ptr<MOBase::IFileTree>& tree);
+  MOBase::IPluginInstaller::EInstallResult executeCSharpScript(std::shared_ptr<MOBase::IFileTree>& tree);
 
 }
 #endif
\ No newline at end of file
@@ -7,6 +7,9 @@
 #include <QString>
 
 #include <msclr\marshal_cppstd.h>
+#include <vcclr.h>
+
+#include "utf8.h"
 
 #using <System.dll>
 
@@ -14,24 +17,46 @@ namespace CSharp {
 
   /**
    * Handy functions.
+   *
+   * Managed strings and QString are both UTF-16, so conversions between them copy the
+   * characters directly from one buffer to the other (the managed string is pinned), and
+   * conversions to std::string produce UTF-8.
    */
   inline std::string to_string(System::String^ value) {
-    return msclr::interop::marshal_as<std::string>(value);
-  }  
+    if (value == nullptr || value->Length == 0) {
+      return {};
+    }
+    pin_ptr<const wchar_t> chars = PtrToStringChars(value);
+    std::string result(Utf8::maxEncodedSize(value->Length), '\0');
+    result.resize(Utf8::encode(reinterpret_cast<const char16_t*>(chars), value->Length, result.data()));
+    return result;
+  }
   inline std::wstring to_wstring(System::String^ value) {
-    return msclr::interop::marshal_as<std::wstring>(value);
+    if (value == nullptr) {
+      return {};
+    }
+    pin_ptr<const wchar_t> chars = PtrToStringChars(value);
+    return std::wstring(chars, value->Length);
   }
   inline QString to_qstring(System::String^ value) {
-    msclr::interop::marshal_context ctx;
-    return QString::fromWCharArray(ctx.marshal_as<const wchar_t*>(value));
+    if (value == nullptr) {
+      return {};
+    }
+    pin_ptr<const wchar_t> chars = PtrToStringChars(value);
+    return QString(reinterpret_cast<const QChar*>(chars), value->Length);
   }
 
   template <class Str>
   inline System::String^ from_string(Str const& string) {
     return msclr::interop::marshal_as<System::String^>(string);
   }
+  inline System::String^ from_string(std::string const& string) {
+    std::u16string result(Utf8::maxDecodedSize(string.size()), u'\0');
+    result.resize(Utf8::decode(string.data(), string.size(), result.data()));
+    return gcnew System::String(reinterpret_cast<const wchar_t*>(result.data()), 0, static_cast<int>(result.size()));
+  }
   inline System::String^ from_string(QString const& string) {
-    return msclr::interop::marshal_as<System::String^>(string.toStdWString().c_str());
+    return gcnew System::String(reinterpret_cast<const wchar_t*>(string.utf16()), 0, string.size());
   }
 
 }
@@ -0,0 +1,223 @@
+#ifndef DATA_INDEX_H
+#define DATA_INDEX_H
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QDir>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include "imoinfo.h"
+
+/**
+ * @brief In-memory index of the virtual data directory.
+ *
+ * Listing the data directory through the organizer requires one VFS query per directory,
+ * which is slow for large folders (textures, meshes) on large setups, and scripts tend to
+ * query the same folders multiple times. This index is a case-insensitive trie of the data
+ * directory where each directory is listed at most once (files with their origins, and
+ * sub-directories) the first time it is accessed.
+ *
+ * The index is a snapshot, it is meant to live for a single installation.
+ */
+class DataIndex {
+
+  struct QStringHash {
+    std::size_t operator()(QString const& value) const { return qHash(value); }
+  };
+
+public:
+
+  /**
+   * @brief A file in the data directory.
+   */
+  struct File {
+    QString name;         // Name of the file.
+    QString filePath;     // Absolute path to the actual file.
+    QString archive;      // Archive containing the file, if any.
+    QStringList origins;  // Origins of the file.
+  };
+
+  /**
+   * @brief A directory in the data directory.
+   */
+  class Directory {
+  public:
+
+    /**
+     * @return the path of this directory relative to the data directory, with native
+     *     separators (empty for the data directory itself).
+     */
+    QString const& path() const { return m_Path; }
+
+    /**
+     * @return the path of the given file of this directory relative to the data directory,
+     *     with native separators.
+     */
+    QString filePath(File const& file) const {
+      return m_Path.isEmpty() ? file.name : m_Path + QDir::separator() + file.name;
+    }
+
+  private:
+
+    friend class DataIndex;
+
+    Directory(QString path) : m_Path(std::move(path)) { }
+
+    QString m_Path;
+    bool m_Loaded = false;
+
+    std::vector<File> m_Files;
+    std::unordered_map<QString, std::size_t, QStringHash> m_FileIndices;
+
+    std::vector<Directory*> m_Directories;
+    std::unordered_map<QString, std::unique_ptr<Directory>, QStringHash> m_DirectoryIndices;
+  };
+
+  DataIndex() = default;
+
+  /**
+   * @brief Create an index of the data directory.
+   *
+   * @param organizer The organizer to query the data directory from.
+   */
+  explicit DataIndex(MOBase::IOrganizer* organizer) :
+    m_Organizer(organizer), m_Root(new Directory(QString())) { }
+
+  /**
+   * @brief Find the directory at the given path.
+   *
+   * @param path Path to the directory, relative to the data directory.
+   *
+   * @return the directory, or a null pointer if there is no such directory.
+   */
+  Directory* directory(QString const& path) {
+    if (m_Root == nullptr) {
+      return nullptr;
+    }
+
+    Directory* current = m_Root.get();
+    for (QString const& name : split(path)) {
+      load(*current);
+      auto it = current->m_DirectoryIndices.find(name.toCaseFolded());
+      if (it == current->m_DirectoryIndices.end()) {
+        return nullptr;
+      }
+      current = it->second.get();
+    }
+
+    return current;
+  }
+
+  /**
+   * @brief Find the file at the given path.
+   *
+   * @param path Path to the file, relative to the data directory.
+   *
+   * @return the file, or a null pointer if there is no such file.
+   */
+  File const* file(QString const& path) {
+    QStringList names = split(path);
+    if (names.isEmpty()) {
+      return nullptr;
+    }
+
+    QString name = names.takeLast();
+    Directory* parent = directory(names.join('/'));
+    if (parent == nullptr) {
+      return nullptr;
+    }
+
+    load(*parent);
+    auto it = parent->m_FileIndices.find(name.toCaseFolded());
+    return it == parent->m_FileIndices.end() ? nullptr : &parent->m_Files[it->second];
+  }
+
+  /**
+   * @brief Call the given function on each file of the given directory.
+   *
+   * @param path Path to the directory, relative to the data directory.
+   * @param recursive If true, files in sub-directories are also visited (after the files
+   *     of their parent).
+   * @param fn Function to call, with the directory and the file.
+   */
+  template <class Fn>
+  void forEachFile(QString const& path, bool recursive, Fn&& fn) {
+    if (Directory* root = directory(path); root != nullptr) {
+      forEachFile(*root, recursive, fn);
+    }
+  }
+
+private:
+
+  /**
+   * @brief Split the given path into its components, ignoring empty and . components.
+   */
+  static QStringList split(QString const& path) {
+    QStringList names;
+    int start = 0;
+    for (int i = 0; i <= path.size(); ++i) {
+      if (i == path.size() || path[i] == '/' || path[i] == '\\') {
+        if (i > start && !(i == start + 1 && path[start] == '.')) {
+          names.append(path.mid(start, i - start));
+        }
+        start = i + 1;
+      }
+    }
+    return names;
+  }
+
+  template <class Fn>
+  void forEachFile(Directory& directory, bool recursive, Fn& fn) {
+    load(directory);
+    for (File const& file : directory.m_Files) {
+      fn(const_cast<Directory const&>(directory), file);
+    }
+    if (recursive) {
+      for (Directory* child : directory.m_Directories) {
+        forEachFile(*child, recursive, fn);
+      }
+    }
+  }
+
+  /**
+   * @brief List the content of the given directory if it has not been done yet.
+   */
+  void load(Directory& directory) {
+    if (directory.m_Loaded) {
+      return;
+    }
+    directory.m_Loaded = true;
+
+    auto infos = m_Organizer->findFileInfos(directory.m_Path, [](MOBase::IOrganizer::FileInfo const&) { return true; });
+    directory.m_Files.reserve(infos.size());
+    for (auto& info : infos) {
+      int slash = std::max(info.filePath.lastIndexOf('/'), info.filePath.lastIndexOf('\\'));
+      QString name = info.filePath.mid(slash + 1);
+      if (directory.m_FileIndices.emplace(name.toCaseFolded(), directory.m_Files.size()).second) {
+        directory.m_Files.push_back({ name, info.filePath, info.archive, info.origins });
+      }
+    }
+
+    const QStringList names = m_Organizer->listDirectories(directory.m_Path);
+    directory.m_Directories.reserve(names.size());
+    for (QString const& name : names) {
+      // MO2 does not like path with . or / (I think), so creating the path manually:
+      auto child = std::unique_ptr<Directory>(
+        new Directory(directory.m_Path.isEmpty() ? name : directory.m_Path + QDir::separator() + name));
+      Directory* ptr = child.get();
+      if (directory.m_DirectoryIndices.emplace(name.toCaseFolded(), std::move(child)).second) {
+        directory.m_Directories.push_back(ptr);
+      }
+    }
+  }
+
+  MOBase::IOrganizer* m_Organizer = nullptr;
+  std::unique_ptr<Directory> m_Root;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include <list>
+#include <unordered_map>
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+/**
+ * @brief In-memory cache of file contents, with a memory budget and least-recently-used
+ * eviction.
+ *
+ * Scripts often read the same (small) files multiple times, e.g. within loops. This cache
+ * is meant to live for a single installation, and keyed by the absolute path of the
+ * files, which are not expected to change during the installation (files written by the
+ * script must be removed from the cache).
+ */
+class FileCache {
+public:
+
+  /**
+   * @brief Create a new cache.
+   *
+   * @param budget Maximum number of bytes stored in the cache.
+   */
+  explicit FileCache(qint64 budget = 0) : m_Budget(budget) { }
+
+  /**
+   * @brief Find the content of the given file, and mark it as recently used.
+   *
+   * @param path Path to the file.
+   *
+   * @return the content of the file, or a null pointer if the file is not in the cache.
+   */
+  QByteArray const* find(QString const& path) {
+    auto it = m_Index.find(path);
+    if (it == m_Index.end()) {
+      ++m_Misses;
+      return nullptr;
+    }
+
+    ++m_Hits;
+    m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+    return &it->second->data;
+  }
+
+  /**
+   * @return true if a file of the given size can be stored in the cache.
+   */
+  bool fits(qint64 size) const { return size <= m_Budget; }
+
+  /**
+   * @brief Add the content of the given file to the cache, evicting the least recently
+   * used files if needed.
+   *
+   * @param path Path to the file.
+   * @param data Content of the file.
+   *
+   * @return the content stored in the cache, or a null pointer if the file does not fit.
+   */
+  QByteArray const* insert(QString const& path, QByteArray data) {
+    if (!fits(data.size())) {
+      return nullptr;
+    }
+
+    remove(path);
+    while (!m_Entries.empty() && m_Size + data.size() > m_Budget) {
+      m_Size -= m_Entries.back().data.size();
+      m_Index.erase(m_Entries.back().path);
+      m_Entries.pop_back();
+    }
+
+    m_Size += data.size();
+    m_Entries.push_front({ path, std::move(data) });
+    m_Index[path] = m_Entries.begin();
+    return &m_Entries.front().data;
+  }
+
+  /**
+   * @brief Remove the given file from the cache, if present.
+   *
+   * @param path Path to the file.
+   */
+  void remove(QString const& path) {
+    auto it = m_Index.find(path);
+    if (it != m_Index.end()) {
+      m_Size -= it->second->data.size();
+      m_Entries.erase(it->second);
+      m_Index.erase(it);
+    }
+  }
+
+  /**
+   * @return the number of look-ups that found a file in the cache.
+   */
+  qint64 hits() const { return m_Hits; }
+
+  /**
+   * @return the number of look-ups that did not find a file in the cache.
+   */
+  qint64 misses() const { return m_Misses; }
+
+private:
+
+  struct Entry {
+    QString path;
+    QByteArray data;
+  };
+
+  struct QStringHash {
+    std::size_t operator()(QString const& value) const { return qHash(value); }
+  };
+
+  qint64 m_Budget;
+  qint64 m_Size = 0;
+  qint64 m_Hits = 0;
+  qint64 m_Misses = 0;
+
+  // Most recently used entries first:
+  std::list<Entry> m_Entries;
+  std::unordered_map<QString, std::list<Entry>::iterator, QStringHash> m_Index;
+};
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef INI_FILE_H
+#define INI_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Formatting-preserving INI document.
+ *
+ * The document is parsed in a single pass over the raw text, and entries are spans of
+ * this text (the text must outlive the document). Sections and keys are compared
+ * case-insensitively (ASCII only), as the games do. When a key appears multiple times in
+ * the same section, the first one is used. As with QSettings, a leading UTF-8 BOM is
+ * skipped, and a ; outside double quotes starts a comment, also after a value.
+ *
+ * Edits are applied as patches to the original text: only the values that change are
+ * replaced, new keys are inserted at the end of their section, and new sections are
+ * appended at the end of the file, so comments, ordering and spacing are preserved and
+ * the output is identical to the input when nothing changes (including the BOM). This
+ * header does not depend on Qt or on the CLR.
+ */
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+class IniDocument {
+public:
+
+  /**
+   * @brief An entry (key = value) of the document.
+   */
+  struct Entry {
+    std::string_view section;
+    std::string_view key;
+    std::string_view value;
+
+    // Offset of the value in the text:
+    std::size_t valueOffset;
+  };
+
+  /**
+   * @brief A modification of the document.
+   */
+  struct Edit {
+    std::string section;
+    std::string key;
+    std::string value;
+  };
+
+  /**
+   * @brief Parse the given text.
+   *
+   * @param text The content of the INI file.
+   */
+  explicit IniDocument(std::string_view text) :
+    m_Text(text), m_Start(text.substr(0, 3) == "\xEF\xBB\xBF" ? 3 : 0) {
+    // Lines before the first section belong to an unnamed section:
+    m_Sections.push_back({ std::string_view(), m_Start });
+    m_SectionIndices.emplace(std::string(), 0);
+    std::size_t section = 0;
+
+    std::size_t start = m_Start;
+    while (start < text.size()) {
+      std::size_t end = text.find('\n', start);
+      end = end == std::string_view::npos ? text.size() : end + 1;
+
+      const std::string_view line = trim(text.substr(start, end - start));
+      if (!line.empty() && line[0] == '[') {
+        std::size_t close = line.find(']');
+        std::string_view name = trim(line.substr(1, close == std::string_view::npos ? line.size() - 1 : close - 1));
+        auto [it, inserted] = m_SectionIndices.emplace(lower(name), m_Sections.size());
+        if (inserted) {
+          m_Sections.push_back({ name, end });
+        }
+        section = it->second;
+        m_Sections[section].end = end;
+      }
+      else if (!line.empty()) {
+        // Comments and lines without = are kept as-is, but extend the section:
+        std::size_t equal = line.find('=');
+        if (line[0] != ';' && line[0] != '#' && equal != std::string_view::npos) {
+          std::string_view key = trim(line.substr(0, equal));
+          std::string_view value = line.substr(equal + 1);
+          value = trim(value.substr(0, commentStart(value)));
+          std::size_t valueOffset = value.empty()
+            ? static_cast<std::size_t>(line.data() - text.data()) + equal + 1
+            : static_cast<std::size_t>(value.data() - text.data());
+          if (m_EntryIndices.emplace(entryKey(m_Sections[section].name, key), m_Entries.size()).second) {
+            m_Entries.push_back({ m_Sections[section].name, key, value, valueOffset });
+          }
+        }
+        m_Sections[section].end = end;
+      }
+
+      start = end;
+    }
+  }
+
+  /**
+   * @return true if the text starts with a UTF-8 BOM, i.e., if the file is in UTF-8
+   *     rather than in the ANSI code page.
+   */
+  bool hasUtf8Bom() const { return m_Start > 0; }
+
+  /**
+   * @return the entries of the document, in order.
+   */
+  std::vector<Entry> const& entries() const { return m_Entries; }
+
+  /**
+   * @brief Find the entry with the given section and key.
+   *
+   * @return the entry, or a null pointer if there is no such entry.
+   */
+  Entry const* find(std::string_view section, std::string_view key) const {
+    auto it = m_EntryIndices.find(entryKey(section, key));
+    return it == m_EntryIndices.end() ? nullptr : &m_Entries[it->second];
+  }
+
+  /**
+   * @brief Apply the given edits to the document.
+   *
+   * @param edits The edits to apply, if multiple edits target the same key, the last
+   *     one is applied.
+   * @param output String where the modified text is written, if anything changes.
+   *
+   * @return true if the text changed, false otherwise (output is left untouched).
+   */
+  bool apply(std::vector<Edit> const& edits, std::string& output) const {
+    const std::string_view newline = m_Text.find("\r\n") != std::string_view::npos ? "\r\n" : "\n";
+
+    // Last edit for each key, in order of first appearance:
+    std::vector<Edit const*> unique;
+    std::unordered_map<std::string, std::size_t> uniqueIndices;
+    for (Edit const& edit : edits) {
+      auto [it, inserted] = uniqueIndices.emplace(entryKey(edit.section, edit.key), unique.size());
+      if (inserted) {
+        unique.push_back(&edit);
+      }
+      else {
+        unique[it->second] = &edit;
+      }
+    }
+
+    std::vector<Patch> patches;
+    std::vector<std::string> newSections;
+    std::unordered_map<std::string, std::size_t> newSectionIndices;
+    for (Edit const* edit : unique) {
+      if (Entry const* entry = find(edit->section, edit->key); entry != nullptr) {
+        if (entry->value != edit->value) {
+          patches.push_back({ entry->valueOffset, entry->value.size(), edit->value });
+        }
+        continue;
+      }
+
+      std::string line = edit->key + "=" + edit->value + std::string(newline);
+      if (auto it = m_SectionIndices.find(lower(edit->section)); it != m_SectionIndices.end()) {
+        std::size_t end = m_Sections[it->second].end;
+        if (end > m_Start && m_Text[end - 1] != '\n') {
+          line.insert(0, newline);
+        }
+        patches.push_back({ end, 0, std::move(line) });
+      }
+      else {
+        auto [sit, inserted] = newSectionIndices.emplace(lower(edit->section), newSections.size());
+        if (inserted) {
+          newSections.push_back("[" + edit->section + "]" + std::string(newline));
+        }
+        newSections[sit->second] += line;
+      }
+    }
+
+    if (patches.empty() && newSections.empty()) {
+      return false;
+    }
+
+    // Insertions at the same offset are kept in order of edits:
+    std::stable_sort(patches.begin(), patches.end(), [](Patch const& a, Patch const& b) {
+      return a.offset < b.offset;
+    });
+
+    std::string result;
+    result.reserve(m_Text.size() + 64 * (patches.size() + newSections.size()));
+    std::size_t position = 0;
+    for (Patch const& patch : patches) {
+      result.append(m_Text.substr(position, patch.offset - position));
+      result.append(patch.replacement);
+      position = patch.offset + patch.length;
+    }
+    result.append(m_Text.substr(position));
+
+    for (std::string const& section : newSections) {
+      if (result.size() > m_Start) {
+        if (result.back() != '\n') {
+          result.append(newline);
+        }
+        result.append(newline);
+      }
+      result.append(section);
+    }
+
+    output = std::move(result);
+    return true;
+  }
+
+private:
+
+  struct Section {
+    std::string_view name;
+
+    // Offset after the last non-empty line of the section:
+    std::size_t end;
+  };
+
+  struct Patch {
+    std::size_t offset;
+    std::size_t length;
+    std::string replacement;
+  };
+
+  static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  static std::string_view trim(std::string_view value) {
+    while (!value.empty() && isSpace(value.front())) {
+      value.remove_prefix(1);
+    }
+    while (!value.empty() && isSpace(value.back())) {
+      value.remove_suffix(1);
+    }
+    return value;
+  }
+
+  /**
+   * @return the position of the first ; outside double quotes in the given value, or npos
+   *     if there is none.
+   */
+  static std::size_t commentStart(std::string_view value) {
+    bool quoted = false;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+      if (value[i] == '"') {
+        quoted = !quoted;
+      }
+      else if (value[i] == ';' && !quoted) {
+        return i;
+      }
+    }
+    return std::string_view::npos;
+  }
+
+  static std::string lower(std::string_view value) {
+    std::string result(value);
+    for (char& c : result) {
+      if (c >= 'A' && c <= 'Z') {
+        c += 'a' - 'A';
+      }
+    }
+    return result;
+  }
+
+  static std::string entryKey(std::string_view section, std::string_view key) {
+    std::string result = lower(section);
+    result.push_back('\0');
+    result += lower(key);
+    return result;
+  }
+
+  std::string_view m_Text;
+
+  // Offset of the first character after the BOM:
+  std::size_t m_Start;
+
+  std::vector<Section> m_Sections;
+  std::unordered_map<std::string, std::size_t> m_SectionIndices;
+
+  std::vector<Entry> m_Entries;
+  std::unordered_map<std::string, std::size_t> m_EntryIndices;
+};
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef INSTALL_BATCH_H
+#define INSTALL_BATCH_H
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <QString>
+
+#include "ifiletree.h"
+
+/**
+ * @brief Batch of entries to copy into a file tree.
+ *
+ * Copying entries one by one resolves the destination path (splitting it and descending
+ * the tree) for each entry, even though batches usually target a handful of directories.
+ * The entries of a batch are grouped by destination directory, each directory is looked
+ * up (or created) once, and the copies are then inserted directly into it.
+ */
+class InstallBatch {
+public:
+
+  using EntryPtr = std::shared_ptr<const MOBase::FileTreeEntry>;
+
+  /**
+   * @brief Add an entry to the batch.
+   *
+   * @param entry The entry to copy.
+   * @param to Destination path of the entry, as for IFileTree::copy() (if empty or
+   *     ending with a separator, the entry keeps its name in the given directory).
+   */
+  void add(EntryPtr entry, QString const& to) {
+    const int separator = std::max(to.lastIndexOf('/'), to.lastIndexOf('\\'));
+
+    Item item{ std::move(entry), to.left(std::max(separator, 0)), to.mid(separator + 1) };
+    if (item.name.isEmpty()) {
+      item.name = item.entry->name();
+    }
+    m_Items.push_back(std::move(item));
+  }
+
+  /**
+   * @return the number of entries in the batch.
+   */
+  std::size_t size() const { return m_Items.size(); }
+
+  /**
+   * @brief Copy the entries of the batch into the given tree.
+   *
+   * Entries are copied in the order they were added within each directory, so if two
+   * entries have the same destination, the first one is copied.
+   *
+   * @param tree The tree to copy the entries to.
+   * @param fn Function called for each copied entry, with the position of the entry in
+   *     the batch and its copy.
+   *
+   * @return the number of copied entries.
+   */
+  template <class Fn>
+  int apply(std::shared_ptr<MOBase::IFileTree> const& tree, Fn&& fn) const {
+    std::map<QString, std::vector<std::size_t>> directories;
+    for (std::size_t i = 0; i < m_Items.size(); ++i) {
+      QString key = m_Items[i].directory;
+      directories[key.replace('\\', '/').toCaseFolded()].push_back(i);
+    }
+
+    int count = 0;
+    for (auto const& [key, items] : directories) {
+      QString const& path = m_Items[items.front()].directory;
+      auto directory = key.isEmpty() ? tree : tree->addDirectory(path);
+      if (directory == nullptr) {
+        continue;
+      }
+
+      for (std::size_t i : items) {
+        if (auto copy = directory->copy(m_Items[i].entry, m_Items[i].name); copy != nullptr) {
+          fn(i, copy);
+          ++count;
+        }
+      }
+    }
+
+    return count;
+  }
+
+private:
+
+  struct Item {
+    EntryPtr entry;
+    QString directory;
+    QString name;
+  };
+
+  std::vector<Item> m_Items;
+};
+
+#endif
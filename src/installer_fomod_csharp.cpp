@@ -16,9 +16,11 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "iinstallationmanager.h"
+#include "log.h"
 
 #include "installer_fomod_predialog.h"
 #include "xml_info_reader.h"
+#include "text_file.h"
 #include "installer_fomod_csharp.h"
 #include "csharp_interface.h"
 
@@ -30,107 +32,101 @@ bool InstallerFomodCSharp::init(IOrganizer *moInfo) {
   return true;
 }
 
-std::shared_ptr<const IFileTree> InstallerFomodCSharp::findFomodDirectory(std::shared_ptr<const IFileTree> tree) const
+InstallerFomodCSharp::FomodLayout InstallerFomodCSharp::probeLayout(std::shared_ptr<const IFileTree> tree) const
 {
-  auto entry = tree->find("fomod", FileTreeEntry::DIRECTORY);
+  // Deepest folder we look into, to bound the probe on degenerate archives:
+  constexpr int MAX_DEPTH = 16;
 
-  if (entry != nullptr) {
-    return entry->astree();
-  }
+  FomodLayout layout;
 
-  if (tree->empty()) {
-    return nullptr;
-  }
+  for (int depth = 0; depth < MAX_DEPTH && tree != nullptr; ++depth) {
+    auto entry = tree->find("fomod", FileTreeEntry::DIRECTORY);
 
-  // We need at least a directory:
-  if (!tree->at(0)->isDir()) {
-    return nullptr;
-  }
+    if (entry != nullptr) {
+      layout.dataRoot = tree;
+      layout.fomodDirectory = entry->astree();
+      break;
+    }
 
-  // But not two:
-  if (tree->size() > 1 && tree->at(1)->isDir()) {
-    return nullptr;
-  }
+    // We need exactly one directory (directories come first in a tree):
+    if (tree->empty() || !tree->at(0)->isDir() || (tree->size() > 1 && tree->at(1)->isDir())) {
+      break;
+    }
 
-  return findFomodDirectory(tree->at(0)->astree());
-}
+    tree = tree->at(0)->astree();
+  }
 
-std::shared_ptr<const FileTreeEntry> InstallerFomodCSharp::findScriptFile(std::shared_ptr<const IFileTree> tree) const {
-  auto fomodDirectory = findFomodDirectory(tree);
-  
-  if (fomodDirectory == nullptr) {
-    return nullptr;
+  if (layout.fomodDirectory == nullptr) {
+    return layout;
   }
 
-  for (auto e : *fomodDirectory) {
-    if (e->isFile() && e->suffix().compare("cs", Qt::CaseInsensitive) == 0) {
-      return e;
+  for (auto e : *layout.fomodDirectory) {
+    if (!e->isFile()) {
+      continue;
+    }
+    if (layout.scriptFile == nullptr && e->suffix().compare("cs", Qt::CaseInsensitive) == 0) {
+      layout.scriptFile = e;
+    }
+    else if (layout.infoFile == nullptr && e->compare("info.xml") == 0) {
+      layout.infoFile = e;
+    }
+    if (layout.scriptFile != nullptr && layout.infoFile != nullptr) {
+      break;
     }
   }
 
-  return nullptr;
+  return layout;
 }
 
-std::shared_ptr<const FileTreeEntry> InstallerFomodCSharp::findInfoFile(std::shared_ptr<const IFileTree> tree) const {
-  auto fomodDirectory = findFomodDirectory(tree);
-
-  if (fomodDirectory == nullptr) {
-    return nullptr;
-  }
-
-  for (auto e : *fomodDirectory) {
-    if (e->isFile() && e->compare("info.xml") == 0) {
-      return e;
+InstallerFomodCSharp::FomodLayout InstallerFomodCSharp::findLayout(std::shared_ptr<const IFileTree> tree) const
+{
+  if (tree != nullptr && m_LayoutTree.lock() == tree) {
+    FomodLayout layout{ m_LayoutDataRoot.lock(), m_LayoutFomodDirectory.lock(), m_LayoutScriptFile.lock(), m_LayoutInfoFile.lock() };
+
+    // Only use the memoized layout if the tree has not been modified in-between:
+    if (layout.fomodDirectory == nullptr
+      || (layout.fomodDirectory->parent() == layout.dataRoot
+        && (layout.scriptFile == nullptr || layout.scriptFile->parent() == layout.fomodDirectory)
+        && (layout.infoFile == nullptr || layout.infoFile->parent() == layout.fomodDirectory))) {
+      return layout;
     }
   }
 
-  return nullptr;
+  FomodLayout layout = probeLayout(tree);
+  m_LayoutTree = tree;
+  m_LayoutDataRoot = layout.dataRoot;
+  m_LayoutFomodDirectory = layout.fomodDirectory;
+  m_LayoutScriptFile = layout.scriptFile;
+  m_LayoutInfoFile = layout.infoFile;
+  return layout;
 }
 
 bool InstallerFomodCSharp::isArchiveSupported(std::shared_ptr<const MOBase::IFileTree> tree) const {
-  return findScriptFile(tree) != nullptr;
+  return findLayout(tree).scriptFile != nullptr;
 }
 
 InstallerFomodCSharp::EInstallResult InstallerFomodCSharp::install(MOBase::GuessedValue<QString>& modName, std::shared_ptr<MOBase::IFileTree>& tree,
   QString& version, int& modID) 
 {
-  static std::set<QString, FileNameComparator> imageSuffixes{ "png", "jpg", "jpeg", "gif", "bmp" };
+  FomodLayout layout = findLayout(tree);
 
   // Extract the script file:
-  auto scriptFile = findScriptFile(tree);
+  auto scriptFile = layout.scriptFile;
   if (scriptFile == nullptr) {
     return EInstallResult::RESULT_NOTATTEMPTED;
   }
 
   // Check if there is a info.xml:
-  auto infoFile = findInfoFile(tree);
+  auto infoFile = layout.infoFile;
 
-  // Set containing everything to extract except the script and the info file:
-  std::set<std::shared_ptr<const FileTreeEntry>> toExtractSet{ scriptFile };
+  // Only the script and the info file are extracted here, everything else is extracted
+  // when the script actually needs it:
+  std::vector<std::shared_ptr<const FileTreeEntry>> toExtract{ scriptFile };
 
   if (infoFile != nullptr) {
-    toExtractSet.insert(infoFile);
+    toExtract.push_back(infoFile);
   }
 
-  // Extract all the images:
-  tree->walk([&](const QString&, auto entry) {
-    if (entry->isFile() && imageSuffixes.count(entry->suffix()) > 0) {
-      toExtractSet.insert(entry);
-    }
-    return IFileTree::WalkReturn::CONTINUE;
-  });
-
-  // Extract everything from the fomod/ folder:
-  auto fomodFolder = findFomodDirectory(tree);
-  fomodFolder->walk([&](const QString&, auto entry) {
-    if (entry->isFile()) {
-      toExtractSet.insert(entry);
-    }
-    return IFileTree::WalkReturn::CONTINUE;
-  });
-
-  // Convert to vector:
-  std::vector toExtract(std::begin(toExtractSet), std::end(toExtractSet));
   QStringList paths(manager()->extractFiles(toExtract));
 
   // If user cancelled:
@@ -147,22 +143,42 @@ InstallerFomodCSharp::EInstallResult InstallerFomodCSharp::install(MOBase::Guess
   if (infoFile != nullptr) {
     QFile file(entryToPath[infoFile]);
     if (file.open(QIODevice::ReadOnly)) {
-      auto info = FomodInfoReader::readXml(file, &FomodInfoReader::parseInfo);
-      if (!std::get<0>(info).isEmpty()) {
-        modName.update(std::get<0>(info), GUESS_META);
+      auto info = FomodInfoReader::readXml(file, [](QXmlStreamReader& reader) {
+        return FomodInfoReader::parseInfo(reader, FomodInfoReader::NAME | FomodInfoReader::ID | FomodInfoReader::VERSION);
+      });
+      if (!info.name.isEmpty()) {
+        modName.update(info.name, GUESS_META);
       }
-      if (std::get<1>(info) != -1) {
-        modID = std::get<1>(info);
+      if (info.id != -1) {
+        modID = info.id;
       }
-      if (!std::get<2>(info).isEmpty()) {
-        version = std::get<2>(info);
+      if (!info.version.isEmpty()) {
+        version = info.version;
       }
     }
   }
 
+  // Read the script, it is used both for compilation and to order the extraction
+  // of the remaining files:
+  QString script;
+  {
+    QFile file(entryToPath[scriptFile]);
+    if (!file.open(QIODevice::ReadOnly)) {
+      log::error("Failed to open '{}': {}", file.fileName(), file.errorString());
+      return EInstallResult::RESULT_FAILED;
+    }
+    script = readTextFile(file, false);
+  }
+
+  // Start extracting the fomod files and compiling the script while the user is
+  // choosing the name:
+  CSharp::beforeInstall(this, manager(), parentWidget(), std::const_pointer_cast<IFileTree>(layout.dataRoot), std::move(entryToPath), script);
+  CSharp::prepareCSharpScript(script);
+
   // Show the dialog:
   InstallerFomodPredialog dialog(modName, parentWidget());
   if (dialog.exec() != QDialog::Accepted) {
+    CSharp::cancelInstall();
     if (dialog.nccRequested()) {
       modName.update(dialog.getName(), GUESS_USER);
       return EInstallResult::RESULT_NOTATTEMPTED;
@@ -178,7 +194,5 @@ InstallerFomodCSharp::EInstallResult InstallerFomodCSharp::install(MOBase::Guess
   modName.update(dialog.getName(), GUESS_USER);
 
   // Run the C# script:
-  const QString scriptPath = entryToPath[scriptFile];
-  CSharp::beforeInstall(this, manager(), parentWidget(), std::const_pointer_cast<IFileTree>(scriptFile->parent()->parent()), std::move(entryToPath));
-  return CSharp::executeCSharpScript(scriptPath, tree);
-}
\ No newline at end of file
+  return CSharp::executeCSharpScript(tree);
+}
@@ -18,6 +18,8 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef INSTALLER_FOMOD_CSHARP_H
 #define INSTALLER_FOMOD_CSHARP_H
 
+#include <memory>
+
 #include "iplugininstallersimple.h"
 
 class InstallerFomodCSharp  : public MOBase::IPluginInstallerSimple
@@ -55,7 +57,8 @@ public:
   virtual QList<MOBase::PluginSetting> settings() const override {
     return {
       MOBase::PluginSetting("enabled", "check to enable this plugin", QVariant(true)),
-      MOBase::PluginSetting("prefer", "prefer this over the NCC based plugin", QVariant(true))
+      MOBase::PluginSetting("prefer", "prefer this over the NCC based plugin", QVariant(true)),
+      MOBase::PluginSetting("cache_size", "memory (in MiB) used to cache the files read by scripts", QVariant(64))
     };
   }
 
@@ -75,11 +78,42 @@ public:
 
 private:
 
+  /**
+   * @brief Location of the FOMOD files in an archive.
+   */
+  struct FomodLayout {
+    std::shared_ptr<const MOBase::IFileTree> dataRoot;        // Directory containing the fomod folder.
+    std::shared_ptr<const MOBase::IFileTree> fomodDirectory;  // The fomod folder.
+    std::shared_ptr<const MOBase::FileTreeEntry> scriptFile;  // The C# script, if any.
+    std::shared_ptr<const MOBase::FileTreeEntry> infoFile;    // The info.xml file, if any.
+  };
+
+  /**
+   * @brief Find the FOMOD files in the given tree.
+   *
+   * The result is memoized for the last tree, since MO2 calls isArchiveSupported() (possibly
+   * multiple times) before calling install() with the same tree.
+   *
+   * @param tree The tree to look into.
+   *
+   * @return the layout of the tree, with null entries for the files that were not found.
+   */
+  FomodLayout findLayout(std::shared_ptr<const MOBase::IFileTree> tree) const;
+
+  /**
+   * @brief Probe the given tree for FOMOD files, see findLayout().
+   */
+  FomodLayout probeLayout(std::shared_ptr<const MOBase::IFileTree> tree) const;
+
   MOBase::IOrganizer* m_MOInfo;
 
-  std::shared_ptr<const MOBase::IFileTree> findFomodDirectory(std::shared_ptr<const MOBase::IFileTree> tree) const;
-  std::shared_ptr<const MOBase::FileTreeEntry> findScriptFile(std::shared_ptr<const MOBase::IFileTree> tree) const;
-  std::shared_ptr<const MOBase::FileTreeEntry> findInfoFile(std::shared_ptr<const MOBase::IFileTree> tree) const;
+  // Last probed tree and its layout, weak pointers are used to not keep trees alive
+  // after the installation:
+  mutable std::weak_ptr<const MOBase::IFileTree> m_LayoutTree;
+  mutable std::weak_ptr<const MOBase::IFileTree> m_LayoutDataRoot;
+  mutable std::weak_ptr<const MOBase::IFileTree> m_LayoutFomodDirectory;
+  mutable std::weak_ptr<const MOBase::FileTreeEntry> m_LayoutScriptFile;
+  mutable std::weak_ptr<const MOBase::FileTreeEntry> m_LayoutInfoFile;
 
 };
 
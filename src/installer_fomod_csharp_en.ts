@@ -10,12 +10,12 @@
     </message>
     <message>
         <location filename="installer_fomod_csharp_postdialog.ui" line="20"/>
-        <source>The installer needs to edit the following settings. You can either apply them, discard them or move them to the mod installation folder (under INI Tweaks).</source>
+        <source>The installer needs to edit the following settings and plugins. You can either apply them, discard them or move the settings to the mod installation folder (under INI Tweaks). The changes to the plugins are applied after the installation unless you discard them.</source>
         <translation type="unfinished"></translation>
     </message>
     <message>
         <location filename="installer_fomod_csharp_postdialog.ui" line="56"/>
-        <source>Apply the settings to the INI files corresponding to the current profile.</source>
+        <source>Apply the settings to the INI files corresponding to the current profile, and the changes to the plugins after the installation.</source>
         <translation type="unfinished"></translation>
     </message>
     <message>
@@ -25,7 +25,7 @@
     </message>
     <message>
         <location filename="installer_fomod_csharp_postdialog.ui" line="66"/>
-        <source>Discard the settings.</source>
+        <source>Discard the settings and the changes to the plugins.</source>
         <translation type="unfinished"></translation>
     </message>
     <message>
@@ -35,7 +35,7 @@
     </message>
     <message>
         <location filename="installer_fomod_csharp_postdialog.ui" line="76"/>
-        <source>Create files under &quot;INI Tweaks&quot; in the mod folder with these settings.</source>
+        <source>Create files under &quot;INI Tweaks&quot; in the mod folder with these settings, and apply the changes to the plugins after the installation.</source>
         <translation type="unfinished"></translation>
     </message>
     <message>
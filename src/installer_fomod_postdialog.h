@@ -43,9 +43,14 @@ public:
   Result result() const { return m_Result; }
 
   /**
+   * @brief Add a tab for each INI file with the settings to apply.
    *
+   * @param settings The settings, per INI file.
    */
   void setIniSettings(std::map<QString, PSettings> const& settings) {
+    // Without settings, only the plugin changes remain, and INI Tweaks is the same
+    // as Apply:
+    ui->moveBtn->setVisible(!settings.empty());
     for (auto p : settings) {
       QTextEdit* widget = new QTextEdit(this);
       widget->append(p.second.toString());
@@ -54,6 +59,18 @@ public:
     }
   }
 
+  /**
+   * @brief Add a tab describing the changes to the plugin list.
+   *
+   * @param description Description of the changes.
+   */
+  void setPluginChanges(QString const& description) {
+    QTextEdit* widget = new QTextEdit(this);
+    widget->append(description);
+    widget->setReadOnly(true);
+    ui->tabWidget->addTab(widget, tr("Plugins"));
+  }
+
 private slots:
 
   void on_discardBtn_clicked() {
@@ -0,0 +1,228 @@
+#ifndef PLUGIN_JOURNAL_H
+#define PLUGIN_JOURNAL_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include "ipluginlist.h"
+
+/**
+ * @brief Journal of the operations made by a script on the plugin list.
+ *
+ * Operations are not applied immediately, since the plugins of the mod being installed
+ * are not in the plugin list yet. The journal is coalesced as operations are recorded:
+ * only the last activation state of each plugin is kept, and reorders are applied to a
+ * working load order, so the whole journal is applied with one call per activation
+ * change and a single load-order change.
+ */
+class PluginJournal {
+public:
+
+  /**
+   * @brief Create a new journal.
+   *
+   * @param loadOrder The current load order.
+   */
+  explicit PluginJournal(QStringList loadOrder) :
+    m_Initial(loadOrder), m_Order(std::move(loadOrder)) { }
+
+  /**
+   * @return the working load order, i.e., with the recorded reorders applied.
+   */
+  QStringList const& loadOrder() const { return m_Order; }
+
+  /**
+   * @return true if the journal does not contain any operation.
+   */
+  bool empty() const { return m_States.empty() && m_Order == m_Initial; }
+
+  /**
+   * @brief Record the activation or deactivation of the given plugin.
+   *
+   * @param name Name of the plugin.
+   * @param active true to activate the plugin, false to deactivate it.
+   */
+  void setActive(QString const& name, bool active) {
+    auto it = m_StateIndices.find(name.toCaseFolded());
+    if (it != m_StateIndices.end()) {
+      m_States[it.value()].second = active;
+    }
+    else {
+      m_StateIndices.insert(name.toCaseFolded(), static_cast<int>(m_States.size()));
+      m_States.emplace_back(name, active);
+    }
+  }
+
+  /**
+   * @brief Record the move of the given plugin to the given index in the load order.
+   *
+   * Plugins that are not in the load order yet (e.g., plugins from the mod being
+   * installed) are added to it, so the indices of the following operations refer to the
+   * load order including these plugins.
+   *
+   * @param name Name of the plugin.
+   * @param index New index of the plugin.
+   */
+  void setIndex(QString const& name, int index) {
+    int current = indexOf(name);
+    QString plugin = current == -1 ? name : m_Order.takeAt(current);
+    m_Order.insert(std::clamp(index, 0, static_cast<int>(m_Order.size())), plugin);
+  }
+
+  /**
+   * @brief Record a reorder of the whole load order.
+   *
+   * @param indices The new load order, where each entry is the current index of a plugin.
+   *
+   * @return true if the order was recorded, false if it is not a permutation of the
+   *     current indices.
+   */
+  bool setLoadOrder(std::vector<int> const& indices) {
+    if (indices.size() != static_cast<std::size_t>(m_Order.size())) {
+      return false;
+    }
+
+    std::vector<bool> seen(indices.size(), false);
+    QStringList order;
+    order.reserve(m_Order.size());
+    for (int index : indices) {
+      if (index < 0 || index >= m_Order.size() || seen[index]) {
+        return false;
+      }
+      seen[index] = true;
+      order.append(m_Order[index]);
+    }
+
+    m_Order = std::move(order);
+    return true;
+  }
+
+  /**
+   * @brief Record the move of the given plugins to the given position.
+   *
+   * The moved plugins keep their relative order.
+   *
+   * @param indices Current indices of the plugins to move.
+   * @param position Index, in the current load order, where the plugins are moved.
+   *
+   * @return true if the move was recorded, false if an index is invalid.
+   */
+  bool moveTo(std::vector<int> indices, int position) {
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    if (!indices.empty() && (indices.front() < 0 || indices.back() >= m_Order.size())) {
+      return false;
+    }
+
+    QStringList moved, remaining;
+    int before = 0;
+    for (int i = 0, k = 0; i < m_Order.size(); ++i) {
+      if (k < static_cast<int>(indices.size()) && indices[k] == i) {
+        moved.append(m_Order[i]);
+        if (i < position) {
+          ++before;
+        }
+        ++k;
+      }
+      else {
+        remaining.append(m_Order[i]);
+      }
+    }
+
+    const int insertAt = std::clamp(position - before, 0, static_cast<int>(remaining.size()));
+    for (int i = 0; i < moved.size(); ++i) {
+      remaining.insert(insertAt + i, moved[i]);
+    }
+
+    m_Order = std::move(remaining);
+    return true;
+  }
+
+  /**
+   * @return a human-readable description of the operations in the journal.
+   */
+  QString toString() const {
+    QString result;
+    for (auto& p : m_States) {
+      result += (p.second ? QObject::tr("Activate %1") : QObject::tr("Deactivate %1")).arg(p.first) + "\n";
+    }
+    if (m_Order != m_Initial) {
+      if (!result.isEmpty()) {
+        result += '\n';
+      }
+      result += QObject::tr("New load order:") + "\n";
+      for (int i = 0; i < m_Order.size(); ++i) {
+        result += QString("%1. %2\n").arg(i).arg(m_Order[i]);
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Apply the operations to the given plugin list.
+   *
+   * Operations on plugins that are not in the plugin list are skipped.
+   *
+   * @param pluginList The plugin list to update.
+   *
+   * @return the names of the plugins whose operations were skipped.
+   */
+  QStringList apply(MOBase::IPluginList* pluginList) const {
+    QStringList skipped;
+    auto missing = [&](QString const& name) {
+      if (pluginList->state(name) != MOBase::IPluginList::STATE_MISSING) {
+        return false;
+      }
+      if (!skipped.contains(name, Qt::CaseInsensitive)) {
+        skipped.append(name);
+      }
+      return true;
+    };
+
+    for (auto& p : m_States) {
+      if (!missing(p.first)) {
+        pluginList->setState(p.first, p.second ? MOBase::IPluginList::STATE_ACTIVE : MOBase::IPluginList::STATE_INACTIVE);
+      }
+    }
+
+    if (m_Order != m_Initial) {
+      QStringList order;
+      order.reserve(m_Order.size());
+      for (QString const& name : m_Order) {
+        if (!missing(name)) {
+          order.append(name);
+        }
+      }
+      pluginList->setLoadOrder(order);
+    }
+
+    return skipped;
+  }
+
+private:
+
+  int indexOf(QString const& name) const {
+    for (int i = 0; i < m_Order.size(); ++i) {
+      if (m_Order[i].compare(name, Qt::CaseInsensitive) == 0) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  QStringList m_Initial;
+  QStringList m_Order;
+
+  // Activation states, in order of first operation, and map from case-folded name to
+  // index:
+  std::vector<std::pair<QString, bool>> m_States;
+  QHash<QString, int> m_StateIndices;
+};
+
+#endif
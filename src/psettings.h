@@ -1,15 +1,23 @@
 #ifndef PSETTINGS_H
 #define PSETTINGS_H
 
-#include <map>
+#include <string>
+#include <vector>
+
+#include <QFile>
+#include <QHash>
+#include <QPair>
+#include <QSaveFile>
 #include <QString>
-#include <QSettings>
+
+#include "ini_file.h"
 
 /**
  * This is a small class that can be used to store INI settings in memory since
  * QSettings is a pain to use without an actual file.
  *
- * It is a much simpler structure since it stores everything as string.
+ * It is a much simpler structure since it stores everything as string. Sections and
+ * keys are case-insensitive (as in the game INI files), and are kept in insertion order.
  */
 struct PSettings {
 
@@ -28,7 +36,22 @@ public: // Value read/write.
    * @param value The value to set.
    */
   void setValue(QString section, QString key, QString value) {
-    m_Values[std::make_pair(section, key)] = value;
+    auto sIt = m_SectionIndices.find(section.toCaseFolded());
+    if (sIt == m_SectionIndices.end()) {
+      sIt = m_SectionIndices.insert(section.toCaseFolded(), static_cast<int>(m_Sections.size()));
+      m_Sections.push_back({ section, {} });
+    }
+
+    auto eKey = qMakePair(sIt.value(), key.toCaseFolded());
+    auto eIt = m_EntryIndices.find(eKey);
+    if (eIt != m_EntryIndices.end()) {
+      m_Entries[eIt.value()].value = value;
+      return;
+    }
+
+    m_EntryIndices.insert(eKey, static_cast<int>(m_Entries.size()));
+    m_Sections[sIt.value()].entries.push_back(static_cast<int>(m_Entries.size()));
+    m_Entries.push_back({ sIt.value(), key, value });
   }
 
   /**
@@ -40,8 +63,8 @@ public: // Value read/write.
    * @return the corresponding value, or an empty string if the section/key does not exist.
    */
   QString value(QString section, QString key) const {
-    auto it = m_Values.find(std::make_pair(section, key));
-    return it == m_Values.end() ? QString() : it->second;
+    int index = find(section, key);
+    return index == -1 ? QString() : m_Entries[index].value;
   }
 
   /**
@@ -53,7 +76,25 @@ public: // Value read/write.
    * @return true if the section/key exist.
    */
   bool hasValue(QString section, QString key) const {
-    return m_Values.find(std::make_pair(section, key)) != m_Values.end();
+    return find(section, key) != -1;
+  }
+
+  /**
+   * @return true if there is no value in these settings.
+   */
+  bool empty() const {
+    return m_Entries.empty();
+  }
+
+  /**
+   * @brief Call the given function with the section, key and value of each entry, in
+   * insertion order.
+   */
+  template <class Fn>
+  void forEach(Fn&& fn) const {
+    for (auto& entry : m_Entries) {
+      fn(m_Sections[entry.section].name, entry.key, entry.value);
+    }
   }
 
 public: // Output:
@@ -66,39 +107,117 @@ public: // Output:
    */
   QString toString() const {
     QString result = "";
-    QString cSection;
-    for (auto& p : m_Values) {
-      if (cSection != p.first.first) {
-        if (!cSection.isEmpty()) {
-          result += '\n';
-        }
-        cSection = p.first.first;
-        result += "[" + cSection + "]\n";
+    for (auto& section : m_Sections) {
+      if (!result.isEmpty()) {
+        result += '\n';
+      }
+      result += "[" + section.name + "]\n";
+      for (int index : section.entries) {
+        result += m_Entries[index].key + "=" + m_Entries[index].value + "\n";
       }
-      result += p.first.second + "=" + p.second + "\n";
     }
     return result;
   }
 
   /**
-   * @brief Update the given QSettings with all the value in this.
+   * @brief Update the given INI file with all the values in this.
+   *
+   * The formatting of the file is preserved, only the lines whose value changes are
+   * modified, and the file is not written at all if nothing changes. The file is
+   * written to a temporary file first and then renamed.
+   *
+   * Values are encoded in the ANSI code page, as the games read them, unless the file
+   * starts with a UTF-8 BOM. As when reading the file, keys before the first section are
+   * in the General section.
+   *
+   * @param path Path to the INI file (created if it does not exist).
    *
-   * @param settings The settings to update.
+   * @return true if the file was updated (or did not need to be), false otherwise.
    */
-  void update(QSettings& settings) const {
-    for (auto& p : m_Values) {
-      if (p.first.first == "General") {
-        settings.setValue(p.first.second, p.second);
+  bool update(QString const& path) const {
+    std::string output;
+    {
+      QFile file(path);
+      QByteArray content;
+      const char* data = nullptr;
+      qint64 size = 0;
+      if (file.exists()) {
+        if (!file.open(QIODevice::ReadOnly)) {
+          return false;
+        }
+        size = file.size();
+        data = size > 0 ? reinterpret_cast<const char*>(file.map(0, size)) : "";
+        if (data == nullptr) {
+          content = file.readAll();
+          data = content.constData();
+        }
+      }
+
+      // The file is unmapped at the end of the scope, before being replaced:
+      IniDocument document(std::string_view(data ? data : "", static_cast<std::size_t>(size)));
+      const bool utf8 = document.hasUtf8Bom();
+
+      std::vector<IniDocument::Edit> edits;
+      edits.reserve(m_Entries.size());
+      for (auto& entry : m_Entries) {
+        std::string section = encode(m_Sections[entry.section].name, utf8);
+        std::string key = encode(entry.key, utf8);
+        if (m_Sections[entry.section].name.compare("General", Qt::CaseInsensitive) == 0
+          && document.find({}, key) != nullptr) {
+          section.clear();
+        }
+        edits.push_back({ std::move(section), std::move(key), encode(entry.value, utf8) });
       }
-      else {
-        settings.setValue(p.first.first + "/" + p.first.second, p.second);
+
+      if (!document.apply(edits, output)) {
+        return true;
       }
     }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+      return false;
+    }
+    file.write(output.data(), static_cast<qint64>(output.size()));
+    return file.commit();
   }
 
 private:
-  // Map from <section, key> to value:
-  std::map<std::pair<QString, QString>, QString> m_Values;
+
+  static std::string encode(QString const& value, bool utf8) {
+    return (utf8 ? value.toUtf8() : value.toLocal8Bit()).toStdString();
+  }
+
+  struct Section {
+    QString name;
+    std::vector<int> entries;
+  };
+
+  struct Entry {
+    int section;
+    QString key;
+    QString value;
+  };
+
+  /**
+   * @return the index of the entry for the given section/key, or -1 if there is none.
+   */
+  int find(QString const& section, QString const& key) const {
+    auto sIt = m_SectionIndices.find(section.toCaseFolded());
+    if (sIt == m_SectionIndices.end()) {
+      return -1;
+    }
+    return m_EntryIndices.value(qMakePair(sIt.value(), key.toCaseFolded()), -1);
+  }
+
+  // Sections in insertion order (with the case of their first insertion), and map from
+  // case-folded name to index:
+  std::vector<Section> m_Sections;
+  QHash<QString, int> m_SectionIndices;
+
+  // Entries in insertion order, and map from <section index, case-folded key> to index:
+  std::vector<Entry> m_Entries;
+  QHash<QPair<int, QString>, int> m_EntryIndices;
 
 };
 
@@ -0,0 +1,253 @@
+#include "script_compiler.h"
+
+#include <QDir>
+
+#include <vcclr.h>
+#include <msclr/lock.h>
+
+#include "log.h"
+
+#include "csharp_utils.h"
+#include "base_script.h"
+
+#using <System.dll>
+
+using namespace MOBase;
+
+namespace CSharp {
+
+  using namespace System;
+  using namespace System::IO;
+  using namespace System::CodeDom::Compiler;
+  using namespace System::Collections::Generic;
+  using namespace System::Reflection;
+  using namespace System::Security::Cryptography;
+
+  // Folder containing the cached assemblies, empty if the cache is disabled:
+  static QString g_CacheFolder;
+
+  // Maximum total size of the cached assemblies, in bytes:
+  static constexpr long long MAX_CACHE_SIZE = 64ll * 1024 * 1024;
+
+  // The compiler and the reference assemblies, created once for the lifetime of the plugin:
+  static gcroot<CodeDomProvider^> g_Provider;
+  static gcroot<array<String^>^> g_References;
+
+  /**
+   * This is a assembly resolve handler that does only one thing: returns the assembly
+   * containing BaseScript (usually the DLL) when requested.
+   *
+   * I don't know why this must be done manually... But I did not find any better solution.
+   */
+  Assembly^ currentDomain_AssemblyResolve(Object^, ResolveEventArgs^ args)
+  {
+    try {
+      Assembly^ baseScriptAssembly = Assembly::GetAssembly(BaseScript::typeid);
+      if (args->Name->Equals(baseScriptAssembly->FullName)) {
+        return baseScriptAssembly;
+      }
+    }
+    catch (...)
+    {
+    }
+
+    return nullptr;
+  }
+
+  /**
+   * @brief Compile the given source with the shared provider.
+   *
+   * @param cp The compiler parameters.
+   * @param source The source to compile.
+   *
+   * @return the compilation results.
+   */
+  CompilerResults^ compile(CompilerParameters^ cp, String^ source) {
+    CodeDomProvider^ provider = g_Provider;
+    msclr::lock lock(provider);
+    return provider->CompileAssemblyFromSource(cp, source);
+  }
+
+  /**
+   * @brief Create the default compiler parameters.
+   */
+  CompilerParameters^ compilerParameters() {
+    CompilerParameters^ cp = gcnew CompilerParameters(g_References);
+    cp->GenerateExecutable = false;
+    cp->IncludeDebugInformation = false;
+    cp->GenerateInMemory = true;
+    cp->TreatWarningsAsErrors = false;
+    return cp;
+  }
+
+  void initCompiler(QString const& cacheFolder) {
+    if (!cacheFolder.isEmpty() && QDir().mkpath(cacheFolder)) {
+      g_CacheFolder = cacheFolder;
+    }
+    else {
+      log::warn("C#: cannot create assembly cache folder '{}', scripts will always be compiled.", cacheFolder);
+      g_CacheFolder = QString();
+    }
+
+    AppDomain::CurrentDomain->AssemblyResolve += gcnew ResolveEventHandler(currentDomain_AssemblyResolve);
+
+    // From Nexus-Mods/fomod-installer:
+    Dictionary<String^, String^>^ dicOptions = gcnew Dictionary<String^, String^>(10);
+    dicOptions->Add("CompilerVersion", "v4.0");
+    g_Provider = CodeDomProvider::CreateProvider("CSharp", dicOptions);
+
+    // List of assemblies (including BaseScript) - From Nexus-Mods/fomod-installer:
+    g_References = gcnew array<String^>{
+      "System.dll",
+      "System.Runtime.dll",
+      "System.Drawing.dll",
+      "System.Windows.Forms.dll",
+      "System.Xml.dll",
+      Assembly::GetAssembly(BaseScript::typeid)->Location
+    };
+  }
+
+  /**
+   * @brief Add the UTF-8 bytes of the given string, followed by a separator, to the hash.
+   */
+  void hashString(HashAlgorithm^ algorithm, String^ value) {
+    array<Byte>^ separator = { 0 };
+    array<Byte>^ bytes = Text::Encoding::UTF8->GetBytes(value);
+    algorithm->TransformBlock(bytes, 0, bytes->Length, nullptr, 0);
+    algorithm->TransformBlock(separator, 0, separator->Length, nullptr, 0);
+  }
+
+  /**
+   * @brief Compute the cache key of the given script.
+   *
+   * The key covers the source of the script, the reference assemblies and the identity
+   * of the assembly containing BaseScript (including its module version ID, so that
+   * assemblies compiled against another build of this plugin are never reused).
+   *
+   * @return the cache key, as a lower-case hexadecimal string.
+   */
+  String^ cacheKey(String^ script, array<String^>^ references) {
+    SHA256^ sha = SHA256::Create();
+    try {
+      hashString(sha, script);
+      for each (String^ reference in references) {
+        hashString(sha, reference);
+      }
+      Assembly^ baseScriptAssembly = Assembly::GetAssembly(BaseScript::typeid);
+      hashString(sha, baseScriptAssembly->FullName);
+      hashString(sha, baseScriptAssembly->ManifestModule->ModuleVersionId.ToString());
+      sha->TransformFinalBlock(gcnew array<Byte>(0), 0, 0);
+      return BitConverter::ToString(sha->Hash)->Replace("-", "")->ToLowerInvariant();
+    }
+    finally {
+      delete sha;
+    }
+  }
+
+  /**
+   * @brief Remove the least recently used assemblies from the cache until its size is
+   * below MAX_CACHE_SIZE.
+   */
+  void evictAssemblies() {
+    auto files = (gcnew DirectoryInfo(from_string(g_CacheFolder)))->GetFiles("*.dll");
+
+    long long totalSize = 0;
+    for each (FileInfo ^ file in files) {
+      totalSize += file->Length;
+    }
+
+    if (totalSize <= MAX_CACHE_SIZE) {
+      return;
+    }
+
+    // The last write time is updated on each cache hit, so oldest first is least recently used:
+    array<DateTime>^ lastUses = gcnew array<DateTime>(files->Length);
+    for (int i = 0; i < files->Length; ++i) {
+      lastUses[i] = files[i]->LastWriteTimeUtc;
+    }
+    Array::Sort(lastUses, files);
+
+    for (int i = 0; i < files->Length && totalSize > MAX_CACHE_SIZE; ++i) {
+      try {
+        long long size = files[i]->Length;
+        files[i]->Delete();
+        totalSize -= size;
+      }
+      catch (IOException^ ex) {
+        log::warn("C#: failed to remove cached assembly '{}': {}", to_string(files[i]->Name), to_string(ex->Message));
+      }
+    }
+  }
+
+  Assembly^ compileScript(String^ script) {
+
+    array<String^>^ references = g_References;
+
+    // Look-up the cache:
+    String^ cachePath = nullptr;
+    if (!g_CacheFolder.isEmpty()) {
+      try {
+        cachePath = Path::Combine(from_string(g_CacheFolder), cacheKey(script, references) + ".dll");
+        if (File::Exists(cachePath)) {
+          // Load from bytes so that the file is not locked and can be evicted later:
+          Assembly^ assembly = Assembly::Load(File::ReadAllBytes(cachePath));
+          File::SetLastWriteTimeUtc(cachePath, DateTime::UtcNow);
+          log::debug("C#: using cached assembly {}.", to_string(Path::GetFileName(cachePath)));
+          return assembly;
+        }
+      }
+      catch (Exception^ ex) {
+        log::warn("C#: failed to load cached assembly: {}", to_string(ex->Message));
+      }
+    }
+
+    CompilerParameters^ cp = compilerParameters();
+
+    // When the cache is enabled, the assembly is written to a temporary file in the cache
+    // folder (the compiler still loads it in memory), and then moved to its final location:
+    String^ tmpPath = nullptr;
+    if (cachePath != nullptr) {
+      tmpPath = Path::Combine(Path::GetDirectoryName(cachePath), Path::GetRandomFileName() + ".tmp");
+      cp->OutputAssembly = tmpPath;
+    }
+
+    // Compile the script
+    auto result = compile(cp, script);
+
+    int errorCount = 0;
+    for each (CompilerError ^ error in result->Errors) {
+      if (error->IsWarning) {
+        log::error("C# [{}]: {}", error->Line, to_string(error->ErrorText));
+      }
+      else {
+        log::warn("C# [{}]: {}", error->Line, to_string(error->ErrorText));
+      }
+      ++errorCount;
+    }
+
+    Assembly^ assembly = errorCount > 0 ? nullptr : result->CompiledAssembly;
+
+    if (tmpPath != nullptr) {
+      try {
+        if (assembly != nullptr) {
+          File::Move(tmpPath, cachePath);
+          evictAssemblies();
+        }
+      }
+      catch (Exception^ ex) {
+        log::warn("C#: failed to store assembly in cache: {}", to_string(ex->Message));
+      }
+
+      try {
+        if (File::Exists(tmpPath)) {
+          File::Delete(tmpPath);
+        }
+      }
+      catch (IOException^) {
+      }
+    }
+
+    return assembly;
+  }
+
+}
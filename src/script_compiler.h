@@ -0,0 +1,31 @@
+#ifndef SCRIPT_COMPILER_H
+#define SCRIPT_COMPILER_H
+
+#include <QString>
+
+#using <System.dll>
+
+namespace CSharp {
+
+  /**
+   * @brief Initialize the script compiler.
+   *
+   * @param cacheFolder Folder where compiled assemblies are cached. If empty, or if the
+   *     folder cannot be created, scripts are always compiled.
+   */
+  void initCompiler(QString const& cacheFolder);
+
+  /**
+   * @brief Compile the given script, or load it from the assembly cache if the exact
+   * same script has already been compiled.
+   *
+   * @param script The source of the script (after rewriting).
+   *
+   * @return the assembly containing the script, or a null handle if the compilation
+   *     failed.
+   */
+  System::Reflection::Assembly^ compileScript(System::String^ script);
+
+}
+
+#endif
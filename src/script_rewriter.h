@@ -0,0 +1,530 @@
+#ifndef SCRIPT_REWRITER_H
+#define SCRIPT_REWRITER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Rewriting of FOMOD C# scripts so that they can be compiled against our BaseScript.
+ *
+ * Scripts written for other mod managers derive from game-specific base classes (e.g.
+ * fomm.Scripting.FalloutNewVegasBaseScript) and import fomm.Scripting. This used to be
+ * done with three regular expressions (from NMM), which backtrack badly on large scripts.
+ * The rewriter below does the same thing with a single pass of a small C# lexer that
+ * knows about comments, strings and class declarations, so text inside comments and
+ * string literals is never rewritten.
+ *
+ * This header does not depend on Qt or on the CLR.
+ */
+namespace CSharp {
+
+  namespace details {
+
+    /**
+     * @brief Minimal C# lexer, only able to find identifiers and punctuations outside
+     * of comments, literals and preprocessor directives.
+     */
+    template <class CharT>
+    class ScriptLexer {
+    public:
+
+      using string_view = std::basic_string_view<CharT>;
+
+      enum class TokenType {
+        END,
+        IDENTIFIER,
+        LITERAL,
+        PUNCTUATION
+      };
+
+      struct Token {
+        TokenType type;
+        std::size_t begin;
+        std::size_t end;
+      };
+
+      ScriptLexer(string_view source) : m_Source(source), m_Position(0) { }
+
+      /**
+       * @return the source being lexed.
+       */
+      string_view source() const { return m_Source; }
+
+      /**
+       * @return the text of the given token.
+       */
+      string_view text(Token const& token) const {
+        return m_Source.substr(token.begin, token.end - token.begin);
+      }
+
+      /**
+       * @return true if the given token is the given identifier.
+       */
+      bool isIdentifier(Token const& token, const char* value) const {
+        return token.type == TokenType::IDENTIFIER && equals(text(token), value);
+      }
+
+      /**
+       * @return true if the given token is the given punctuation.
+       */
+      bool isPunctuation(Token const& token, char value) const {
+        return token.type == TokenType::PUNCTUATION && m_Source[token.begin] == CharT(value);
+      }
+
+      /**
+       * @return the next token, skipping whitespaces, comments and preprocessor directives.
+       */
+      Token next() {
+        skipTrivia();
+
+        if (m_Position >= m_Source.size()) {
+          return { TokenType::END, m_Source.size(), m_Source.size() };
+        }
+
+        const std::size_t begin = m_Position;
+        const CharT c = m_Source[m_Position];
+
+        if (c == '"') {
+          skipString(false, false);
+          return { TokenType::LITERAL, begin, m_Position };
+        }
+
+        if (c == '\'') {
+          skipCharacter();
+          return { TokenType::LITERAL, begin, m_Position };
+        }
+
+        if (c == '@' || c == '$') {
+          // Verbatim and/or interpolated strings: @"...", $"...", $@"..." or @$"...":
+          bool verbatim = false, interpolated = false;
+          std::size_t i = m_Position;
+          while (i < m_Source.size() && (m_Source[i] == '@' || m_Source[i] == '$') && i - m_Position < 2) {
+            verbatim |= m_Source[i] == '@';
+            interpolated |= m_Source[i] == '$';
+            ++i;
+          }
+          if (i < m_Source.size() && m_Source[i] == '"') {
+            m_Position = i;
+            skipString(verbatim, interpolated);
+            return { TokenType::LITERAL, begin, m_Position };
+          }
+
+          // Verbatim identifier (e.g. @class):
+          if (c == '@' && m_Position + 1 < m_Source.size() && isIdentifierStart(m_Source[m_Position + 1])) {
+            m_Position += 2;
+            skipIdentifier();
+            return { TokenType::IDENTIFIER, begin, m_Position };
+          }
+        }
+
+        if (isIdentifierStart(c)) {
+          ++m_Position;
+          skipIdentifier();
+          return { TokenType::IDENTIFIER, begin, m_Position };
+        }
+
+        if (c >= '0' && c <= '9') {
+          // Numbers are not interesting, just skip them (including suffixes, exponents, etc.):
+          while (m_Position < m_Source.size() && (isIdentifierPart(m_Source[m_Position]) || m_Source[m_Position] == '.')) {
+            ++m_Position;
+          }
+          return { TokenType::LITERAL, begin, m_Position };
+        }
+
+        ++m_Position;
+        return { TokenType::PUNCTUATION, begin, m_Position };
+      }
+
+    private:
+
+      static bool equals(string_view value, const char* expected) {
+        std::size_t i = 0;
+        for (; expected[i] != '\0'; ++i) {
+          if (i >= value.size() || value[i] != CharT(expected[i])) {
+            return false;
+          }
+        }
+        return i == value.size();
+      }
+
+      static bool isIdentifierStart(CharT c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || static_cast<std::size_t>(c) >= 0x80;
+      }
+
+      static bool isIdentifierPart(CharT c) {
+        return isIdentifierStart(c) || (c >= '0' && c <= '9');
+      }
+
+      void skipIdentifier() {
+        while (m_Position < m_Source.size() && isIdentifierPart(m_Source[m_Position])) {
+          ++m_Position;
+        }
+      }
+
+      void skipLine() {
+        while (m_Position < m_Source.size() && m_Source[m_Position] != '\n') {
+          ++m_Position;
+        }
+      }
+
+      void skipTrivia() {
+        while (m_Position < m_Source.size()) {
+          const CharT c = m_Source[m_Position];
+          if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v' || c == 0xFEFF) {
+            ++m_Position;
+          }
+          else if (c == '/' && m_Position + 1 < m_Source.size() && m_Source[m_Position + 1] == '/') {
+            skipLine();
+          }
+          else if (c == '/' && m_Position + 1 < m_Source.size() && m_Source[m_Position + 1] == '*') {
+            auto end = m_Source.find(string_view(s_CommentEnd, 2), m_Position + 2);
+            m_Position = end == string_view::npos ? m_Source.size() : end + 2;
+          }
+          else if (c == '#') {
+            // '#' is only valid in preprocessor directives outside of literals:
+            skipLine();
+          }
+          else {
+            break;
+          }
+        }
+      }
+
+      /**
+       * @brief Skip a string literal, m_Position must be on the opening quote.
+       */
+      void skipString(bool verbatim, bool interpolated) {
+        ++m_Position;
+        while (m_Position < m_Source.size()) {
+          const CharT c = m_Source[m_Position];
+          if (c == '"') {
+            // "" is an escaped quote in verbatim strings:
+            if (verbatim && m_Position + 1 < m_Source.size() && m_Source[m_Position + 1] == '"') {
+              m_Position += 2;
+              continue;
+            }
+            ++m_Position;
+            return;
+          }
+          else if (c == '\\' && !verbatim) {
+            m_Position += 2;
+          }
+          else if (c == '\n' && !verbatim) {
+            // Unterminated string, stop here:
+            return;
+          }
+          else if (c == '{' && interpolated) {
+            if (m_Position + 1 < m_Source.size() && m_Source[m_Position + 1] == '{') {
+              m_Position += 2;
+            }
+            else {
+              skipInterpolation();
+            }
+          }
+          else {
+            ++m_Position;
+          }
+        }
+      }
+
+      /**
+       * @brief Skip an interpolation hole, m_Position must be on the opening brace.
+       */
+      void skipInterpolation() {
+        ++m_Position;
+        int depth = 1;
+        while (depth > 0) {
+          Token token = next();
+          if (token.type == TokenType::END) {
+            return;
+          }
+          if (isPunctuation(token, '{')) {
+            ++depth;
+          }
+          else if (isPunctuation(token, '}')) {
+            --depth;
+          }
+        }
+      }
+
+      /**
+       * @brief Skip a character literal, m_Position must be on the opening quote.
+       */
+      void skipCharacter() {
+        ++m_Position;
+        while (m_Position < m_Source.size()) {
+          const CharT c = m_Source[m_Position];
+          if (c == '\'') {
+            ++m_Position;
+            return;
+          }
+          else if (c == '\\') {
+            m_Position += 2;
+          }
+          else if (c == '\n') {
+            return;
+          }
+          else {
+            ++m_Position;
+          }
+        }
+      }
+
+      static constexpr CharT s_CommentEnd[] = { '*', '/' };
+
+      string_view m_Source;
+      std::size_t m_Position;
+    };
+
+    template <class CharT>
+    bool endsWith(std::basic_string_view<CharT> value, const char* suffix) {
+      const std::size_t length = std::char_traits<char>::length(suffix);
+      if (value.size() < length) {
+        return false;
+      }
+      for (std::size_t i = 0; i < length; ++i) {
+        if (value[value.size() - length + i] != CharT(suffix[i])) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  }
+
+  /**
+   * @brief Rewrite the given script so that it can be compiled against our BaseScript.
+   *
+   * - The base class of the Script class (the first base type whose name ends with
+   *   BaseScript, e.g. fomm.Scripting.FalloutNewVegasBaseScript) is replaced by BaseScript,
+   *   and so is the base type of every other class deriving from the same class (qualified
+   *   or not).
+   * - using fomm.Scripting; directives are removed (with the whitespaces preceding them).
+   *
+   * @param source The source of the script.
+   *
+   * @return the rewritten source.
+   */
+  template <class CharT>
+  std::basic_string<CharT> rewriteScript(std::basic_string_view<CharT> source) {
+    using Lexer = details::ScriptLexer<CharT>;
+    using TokenType = typename Lexer::TokenType;
+    using Token = typename Lexer::Token;
+
+    // An edit replaces [begin, end) by BaseScript, or removes it:
+    struct Edit {
+      std::size_t begin;
+      std::size_t end;
+      bool remove;
+      // For base types, the last part of the (qualified) name:
+      std::basic_string_view<CharT> name;
+      // For base types, true if this is the base class of the Script class:
+      bool script;
+    };
+
+    std::vector<Edit> edits;
+    Lexer lexer(source);
+
+    Token token = lexer.next();
+
+    // Skip generic parameters or arguments, token must be on the opening '<':
+    auto skipGeneric = [&]() {
+      int depth = 0;
+      do {
+        if (lexer.isPunctuation(token, '<')) {
+          ++depth;
+        }
+        else if (lexer.isPunctuation(token, '>')) {
+          --depth;
+        }
+        token = lexer.next();
+      } while (depth > 0 && token.type != TokenType::END);
+    };
+
+    while (token.type != TokenType::END) {
+
+      // using fomm.Scripting;
+      if (lexer.isIdentifier(token, "using")) {
+        std::size_t begin = token.begin;
+        while (begin > 0 && (source[begin - 1] == ' ' || source[begin - 1] == '\t' || source[begin - 1] == '\r' || source[begin - 1] == '\n')) {
+          --begin;
+        }
+
+        token = lexer.next();
+        if (!lexer.isIdentifier(token, "fomm")) {
+          continue;
+        }
+        token = lexer.next();
+        if (!lexer.isPunctuation(token, '.')) {
+          continue;
+        }
+        token = lexer.next();
+        if (!lexer.isIdentifier(token, "Scripting")) {
+          continue;
+        }
+        token = lexer.next();
+        if (!lexer.isPunctuation(token, ';')) {
+          continue;
+        }
+        edits.push_back({ begin, token.end, true, {}, false });
+        token = lexer.next();
+      }
+
+      // class Name<...> : Base1, Base2 ...
+      else if (lexer.isIdentifier(token, "class")) {
+        token = lexer.next();
+
+        // Not a declaration (e.g., a "where T : class" constraint):
+        if (token.type != TokenType::IDENTIFIER) {
+          continue;
+        }
+
+        const bool isScript = lexer.isIdentifier(token, "Script");
+        token = lexer.next();
+        if (lexer.isPunctuation(token, '<')) {
+          skipGeneric();
+        }
+
+        if (!lexer.isPunctuation(token, ':')) {
+          continue;
+        }
+
+        bool scriptBaseFound = false;
+        do {
+          token = lexer.next();
+
+          // Qualified name (with . or ::):
+          Token first = token, last = token;
+          while (token.type == TokenType::IDENTIFIER) {
+            last = token;
+            token = lexer.next();
+            if (lexer.isPunctuation(token, '.')) {
+              token = lexer.next();
+            }
+            else if (lexer.isPunctuation(token, ':')) {
+              token = lexer.next();
+              if (!lexer.isPunctuation(token, ':')) {
+                break;
+              }
+              token = lexer.next();
+            }
+            else {
+              break;
+            }
+          }
+
+          if (first.type == TokenType::IDENTIFIER) {
+            auto name = lexer.text(last);
+            bool script = isScript && !scriptBaseFound && details::endsWith(name, "BaseScript");
+            scriptBaseFound |= script;
+            edits.push_back({ first.begin, last.end, false, name, script });
+          }
+
+          if (lexer.isPunctuation(token, '<')) {
+            skipGeneric();
+          }
+        } while (lexer.isPunctuation(token, ','));
+      }
+      else {
+        token = lexer.next();
+      }
+    }
+
+    // Find the name of the base class of the Script class:
+    std::basic_string_view<CharT> scriptBase;
+    for (auto& edit : edits) {
+      if (edit.script) {
+        scriptBase = edit.name;
+        break;
+      }
+    }
+
+    // Apply the edits:
+    std::basic_string<CharT> result;
+    result.reserve(source.size());
+
+    std::size_t position = 0;
+    for (auto& edit : edits) {
+      if (!edit.remove && !edit.script && (scriptBase.empty() || edit.name != scriptBase)) {
+        continue;
+      }
+      result.append(source.substr(position, edit.begin - position));
+      if (!edit.remove) {
+        static constexpr CharT baseScript[] = { 'B', 'a', 's', 'e', 'S', 'c', 'r', 'i', 'p', 't' };
+        result.append(baseScript, sizeof(baseScript) / sizeof(CharT));
+      }
+      position = edit.end;
+    }
+    result.append(source.substr(position));
+
+    return result;
+  }
+
+  /**
+   * @brief Call the given function with the content of each string literal of the given
+   * script, and the name of the innermost call the literal is an argument of.
+   *
+   * Interpolated strings are ignored, and only the escape sequences that can appear in
+   * paths are interpreted (\\, \" and "" in verbatim strings). The name of the call is
+   * the last identifier before the opening parenthesis (e.g. GetFileFromMod for
+   * BaseScript.GetFileFromMod("a") or SelectOption for new SelectOption("a")), and is
+   * empty for literals that are not inside parentheses.
+   *
+   * @param source The source of the script.
+   * @param fn The function to call, with the name of the call and the content of the
+   *     literal.
+   */
+  template <class CharT, class Fn>
+  void forEachStringLiteral(std::basic_string_view<CharT> source, Fn&& fn) {
+    using Lexer = details::ScriptLexer<CharT>;
+    using TokenType = typename Lexer::TokenType;
+
+    Lexer lexer(source);
+    std::basic_string<CharT> content;
+    std::vector<std::basic_string_view<CharT>> calls;
+    typename Lexer::Token previous{ TokenType::END, 0, 0 };
+    for (auto token = lexer.next(); token.type != TokenType::END; previous = token, token = lexer.next()) {
+      if (lexer.isPunctuation(token, '(')) {
+        calls.push_back(previous.type == TokenType::IDENTIFIER ? lexer.text(previous) : std::basic_string_view<CharT>());
+        continue;
+      }
+      if (lexer.isPunctuation(token, ')')) {
+        if (!calls.empty()) {
+          calls.pop_back();
+        }
+        continue;
+      }
+      if (token.type != TokenType::LITERAL) {
+        continue;
+      }
+
+      auto text = lexer.text(token);
+      const bool verbatim = text[0] == '@' && text.size() > 1 && text[1] == '"';
+      if (!verbatim && text[0] != '"') {
+        continue;
+      }
+
+      text.remove_prefix(verbatim ? 2 : 1);
+      if (!text.empty() && text.back() == '"') {
+        text.remove_suffix(1);
+      }
+
+      content.clear();
+      for (std::size_t i = 0; i < text.size(); ++i) {
+        if (verbatim && text[i] == '"' && i + 1 < text.size() && text[i + 1] == '"') {
+          ++i;
+        }
+        else if (!verbatim && text[i] == '\\' && i + 1 < text.size() && (text[i + 1] == '\\' || text[i + 1] == '"')) {
+          ++i;
+        }
+        content.push_back(text[i]);
+      }
+
+      fn(calls.empty() ? std::basic_string_view<CharT>() : calls.back(), content);
+    }
+  }
+
+}
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef SOURCE_INDEX_H
+#define SOURCE_INDEX_H
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <QHash>
+#include <QString>
+#include <QStringView>
+
+#include "ifiletree.h"
+
+/**
+ * @brief Read-only, flat snapshot of the archive tree being installed.
+ *
+ * The IFileTree of the archive is walked once when the installation starts, and all
+ * the look-ups made by the script (which can be thousands for scripts that install files
+ * one by one) are then served from this snapshot instead of splitting the path and
+ * descending the tree each time.
+ *
+ * Entries are stored in pre-order (the descendants of an entry are the entries in
+ * [index + 1, end(index))), as struct-of-arrays. Names are stored in a single buffer
+ * (with a case-folded copy), and a hash table maps (parent, case-folded name) to the
+ * index of the child, so a look-up costs one hash per path component and does not
+ * allocate beyond folding the requested path.
+ */
+class SourceIndex {
+public:
+
+  using EntryPtr = std::shared_ptr<const MOBase::FileTreeEntry>;
+
+  // Index returned when an entry is not found:
+  static constexpr int NONE = -1;
+
+  // Index of the root of the tree:
+  static constexpr int ROOT = 0;
+
+  SourceIndex() = default;
+
+  /**
+   * @brief Create a snapshot of the given tree.
+   *
+   * @param root The tree to index.
+   */
+  explicit SourceIndex(std::shared_ptr<const MOBase::IFileTree> root) {
+    add(root, NONE, QString());
+    m_FoldedNames = m_Names.toCaseFolded();
+
+    m_Children.reserve(m_Entries.size());
+    for (int i = 1; i < size(); ++i) {
+      m_Children.emplace(Key{ m_Parents[i], foldedName(i) }, i);
+    }
+  }
+
+  /**
+   * @return the number of entries in the index, including the root.
+   */
+  int size() const { return static_cast<int>(m_Entries.size()); }
+
+  /**
+   * @brief Find the entry at the given path.
+   *
+   * The look-up is case-insensitive, and both / and \ are accepted as separators.
+   *
+   * @param path The path of the entry, relative to the root.
+   * @param from Index of the entry the path is relative to.
+   *
+   * @return the index of the entry, or NONE if there is no such entry.
+   */
+  int find(QString const& path, int from = ROOT) const {
+    if (from == NONE || m_Entries.empty()) {
+      return NONE;
+    }
+
+    const QString folded = path.toCaseFolded();
+    QStringView view(folded);
+
+    int current = from;
+    int start = 0;
+    for (int i = 0; i <= view.size(); ++i) {
+      if (i < view.size() && view[i] != '/' && view[i] != '\\') {
+        continue;
+      }
+
+      QStringView component = view.mid(start, i - start);
+      start = i + 1;
+
+      if (component.isEmpty() || component == QLatin1String(".")) {
+        continue;
+      }
+
+      auto it = m_Children.find(Key{ current, component });
+      if (it == m_Children.end()) {
+        return NONE;
+      }
+      current = it->second;
+    }
+
+    return current;
+  }
+
+  /**
+   * @return the entry at the given index, or a null pointer for NONE.
+   */
+  EntryPtr entry(int index) const {
+    return index == NONE ? nullptr : m_Entries[index];
+  }
+
+  /**
+   * @return the name of the entry at the given index.
+   */
+  QStringView name(int index) const {
+    return QStringView(m_Names).mid(m_NameOffsets[index], m_NameLengths[index]);
+  }
+
+  /**
+   * @return the index of the parent of the given entry, or NONE for the root.
+   */
+  int parent(int index) const { return m_Parents[index]; }
+
+  /**
+   * @return one past the index of the last descendant of the given entry.
+   */
+  int end(int index) const { return m_Ends[index]; }
+
+  /**
+   * @return true if the entry at the given index is a directory.
+   */
+  bool isDir(int index) const { return m_Entries[index]->isDir(); }
+
+  /**
+   * @return true if the entry at the given index is a file.
+   */
+  bool isFile(int index) const { return !isDir(index); }
+
+  /**
+   * @brief Compute the path of the given entry.
+   *
+   * @param index Index of the entry.
+   * @param separator The separator to use.
+   *
+   * @return the path of the entry, relative to the root.
+   */
+  QString path(int index, QChar separator = '/') const {
+    int length = 0;
+    for (int i = index; i != ROOT && i != NONE; i = m_Parents[i]) {
+      length += m_NameLengths[i] + 1;
+    }
+
+    QString result(std::max(length - 1, 0), Qt::Uninitialized);
+    int position = result.size();
+    for (int i = index; i != ROOT && i != NONE; i = m_Parents[i]) {
+      position -= m_NameLengths[i];
+      std::copy_n(m_Names.constData() + m_NameOffsets[i], m_NameLengths[i], result.data() + position);
+      if (position > 0) {
+        result[--position] = separator;
+      }
+    }
+
+    return result;
+  }
+
+private:
+
+  struct Key {
+    int parent;
+    QStringView name;
+
+    bool operator==(Key const& other) const {
+      return parent == other.parent && name == other.name;
+    }
+  };
+
+  struct KeyHash {
+    std::size_t operator()(Key const& key) const {
+      return qHash(key.name, static_cast<uint>(key.parent));
+    }
+  };
+
+  QStringView foldedName(int index) const {
+    return QStringView(m_FoldedNames).mid(m_NameOffsets[index], m_NameLengths[index]);
+  }
+
+  void add(std::shared_ptr<const MOBase::FileTreeEntry> entry, int parent, QString const& name) {
+    const int index = size();
+    m_Entries.push_back(entry);
+    m_Parents.push_back(parent);
+    m_NameOffsets.push_back(m_Names.size());
+    m_NameLengths.push_back(name.size());
+    m_Ends.push_back(index + 1);
+    m_Names.append(name);
+
+    if (entry->isDir()) {
+      for (auto child : *entry->astree()) {
+        add(child, index, child->name());
+      }
+      m_Ends[index] = size();
+    }
+  }
+
+  // Struct-of-arrays, indexed by entry:
+  std::vector<EntryPtr> m_Entries;
+  std::vector<int> m_Parents;
+  std::vector<int> m_Ends;
+  std::vector<int> m_NameOffsets;
+  std::vector<int> m_NameLengths;
+
+  // All the names, and their case-folded version (same offsets, since Qt uses simple
+  // case folding):
+  QString m_Names;
+  QString m_FoldedNames;
+
+  // Map from (parent, case-folded name) to index:
+  std::unordered_map<Key, int, KeyHash> m_Children;
+};
+
+#endif
@@ -0,0 +1,367 @@
+#ifndef TEXT_DECODER_H
+#define TEXT_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXT_DECODER_SSE2
+#include <emmintrin.h>
+#endif
+
+/**
+ * Encoding detection and decoding of the text files found in FOMOD archives (script.cs
+ * and info.xml).
+ *
+ * Detection is done in a single scan of the raw bytes (BOM, XML declaration and UTF-8
+ * validity), and the bytes are then decoded exactly once to UTF-16. This header does not
+ * depend on Qt or on the CLR.
+ */
+
+// The kernels below are hot loops, no point in compiling them to IL:
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace TextDecoder {
+
+  enum class Encoding {
+    UTF8,
+    UTF16LE,
+    UTF16BE,
+
+    // Used for 8-bit files that are not valid UTF-8 (this is a superset of ISO-8859-1
+    // for all printable characters):
+    WINDOWS_1252
+  };
+
+  struct Detection {
+    Encoding encoding;
+
+    // Number of bytes to skip at the beginning of the data (BOM):
+    std::size_t offset;
+  };
+
+  namespace details {
+
+    /**
+     * @return the number of leading ASCII bytes in the given data.
+     */
+    inline std::size_t asciiPrefix(const unsigned char* data, std::size_t size) {
+      std::size_t i = 0;
+#ifdef TEXT_DECODER_SSE2
+      for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        if (_mm_movemask_epi8(chunk) != 0) {
+          break;
+        }
+      }
+#endif
+      while (i < size && data[i] < 0x80) {
+        ++i;
+      }
+      return i;
+    }
+
+    /**
+     * @brief Widen the given ASCII bytes to UTF-16.
+     */
+    inline void widenAscii(const unsigned char* data, std::size_t size, char16_t* out) {
+      std::size_t i = 0;
+#ifdef TEXT_DECODER_SSE2
+      const __m128i zero = _mm_setzero_si128();
+      for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(chunk, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(chunk, zero));
+      }
+#endif
+      for (; i < size; ++i) {
+        out[i] = data[i];
+      }
+    }
+
+    /**
+     * @brief Decode a single UTF-8 sequence.
+     *
+     * @param data The data, starting with the first byte of the sequence.
+     * @param size The number of available bytes.
+     * @param codepoint The decoded code point.
+     *
+     * @return the length of the sequence, or 0 if the sequence is invalid.
+     */
+    inline std::size_t decodeUtf8(const unsigned char* data, std::size_t size, char32_t& codepoint) {
+      const unsigned char c = data[0];
+      std::size_t length;
+      char32_t min;
+      if (c < 0x80) {
+        codepoint = c;
+        return 1;
+      }
+      else if ((c & 0xE0) == 0xC0) {
+        length = 2;
+        min = 0x80;
+        codepoint = c & 0x1F;
+      }
+      else if ((c & 0xF0) == 0xE0) {
+        length = 3;
+        min = 0x800;
+        codepoint = c & 0x0F;
+      }
+      else if ((c & 0xF8) == 0xF0) {
+        length = 4;
+        min = 0x10000;
+        codepoint = c & 0x07;
+      }
+      else {
+        return 0;
+      }
+
+      if (size < length) {
+        return 0;
+      }
+
+      for (std::size_t i = 1; i < length; ++i) {
+        if ((data[i] & 0xC0) != 0x80) {
+          return 0;
+        }
+        codepoint = (codepoint << 6) | (data[i] & 0x3F);
+      }
+
+      // Overlong encodings, surrogates and out-of-range code points:
+      if (codepoint < min || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        return 0;
+      }
+
+      return length;
+    }
+
+    inline bool startsWith(const unsigned char* data, std::size_t size, std::initializer_list<unsigned char> prefix) {
+      if (size < prefix.size()) {
+        return false;
+      }
+      std::size_t i = 0;
+      for (auto c : prefix) {
+        if (data[i++] != c) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    /**
+     * @brief Find the encoding declared in the XML declaration of an 8-bit file.
+     *
+     * @return the declared encoding, or an empty string if there is none.
+     */
+    inline std::string_view declaredXmlEncoding(const unsigned char* data, std::size_t size) {
+      std::string_view text(reinterpret_cast<const char*>(data), size);
+      if (text.substr(0, 5) != "<?xml") {
+        return {};
+      }
+
+      text = text.substr(0, text.find("?>"));
+      auto pos = text.find("encoding");
+      if (pos == std::string_view::npos) {
+        return {};
+      }
+
+      pos = text.find_first_of("\"'", pos);
+      if (pos == std::string_view::npos) {
+        return {};
+      }
+      auto end = text.find(text[pos], pos + 1);
+      if (end == std::string_view::npos) {
+        return {};
+      }
+
+      return text.substr(pos + 1, end - pos - 1);
+    }
+
+    inline bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+      if (a.size() != b.size()) {
+        return false;
+      }
+      for (std::size_t i = 0; i < a.size(); ++i) {
+        char ca = a[i] >= 'A' && a[i] <= 'Z' ? a[i] - 'A' + 'a' : a[i];
+        char cb = b[i] >= 'A' && b[i] <= 'Z' ? b[i] - 'A' + 'a' : b[i];
+        if (ca != cb) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    // Windows-1252 characters for 0x80 - 0x9F (unassigned bytes are mapped to the
+    // corresponding C1 control, as Windows does):
+    constexpr char16_t WINDOWS_1252_HIGH[32] = {
+      0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+      0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+      0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+      0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+    };
+
+  }
+
+  /**
+   * @return true if the given data is valid UTF-8.
+   */
+  inline bool isValidUtf8(const unsigned char* data, std::size_t size) {
+    std::size_t i = 0;
+    while (i < size) {
+      i += details::asciiPrefix(data + i, size - i);
+      if (i >= size) {
+        break;
+      }
+      char32_t codepoint;
+      std::size_t length = details::decodeUtf8(data + i, size - i, codepoint);
+      if (length == 0) {
+        return false;
+      }
+      i += length;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Detect the encoding of the given data.
+   *
+   * The detection uses, in order, the BOM, the position of the null bytes in the XML
+   * declaration (UTF-16 without BOM), the encoding from the XML declaration (only for
+   * 8-bit encodings since the file is known to be 8-bit at this point), and finally a
+   * UTF-8 validity check, falling back to Windows-1252.
+   *
+   * @param data The data.
+   * @param size The size of the data.
+   * @param xml true if the data is XML.
+   *
+   * @return the detected encoding.
+   */
+  inline Detection detect(const unsigned char* data, std::size_t size, bool xml) {
+    using details::startsWith;
+
+    if (startsWith(data, size, { 0xEF, 0xBB, 0xBF })) {
+      return { Encoding::UTF8, 3 };
+    }
+    if (startsWith(data, size, { 0xFF, 0xFE })) {
+      return { Encoding::UTF16LE, 2 };
+    }
+    if (startsWith(data, size, { 0xFE, 0xFF })) {
+      return { Encoding::UTF16BE, 2 };
+    }
+
+    if (xml) {
+      if (startsWith(data, size, { 0x3C, 0x00, 0x3F, 0x00 })) {
+        return { Encoding::UTF16LE, 0 };
+      }
+      if (startsWith(data, size, { 0x00, 0x3C, 0x00, 0x3F })) {
+        return { Encoding::UTF16BE, 0 };
+      }
+
+      // The file is 8-bit, so a declared UTF-16 encoding is wrong and ignored (this is
+      // a common error in info.xml files):
+      auto declared = details::declaredXmlEncoding(data, size);
+      for (auto name : { "iso-8859-1", "latin1", "windows-1252", "cp1252" }) {
+        if (details::equalsIgnoreCase(declared, name)) {
+          return { Encoding::WINDOWS_1252, 0 };
+        }
+      }
+    }
+
+    return { isValidUtf8(data, size) ? Encoding::UTF8 : Encoding::WINDOWS_1252, 0 };
+  }
+
+  /**
+   * @return an upper bound on the number of UTF-16 code units needed to decode
+   *     size bytes in the given encoding.
+   */
+  inline std::size_t maxDecodedSize(Encoding encoding, std::size_t size) {
+    switch (encoding) {
+    case Encoding::UTF16LE:
+    case Encoding::UTF16BE:
+      return size / 2;
+    default:
+      return size;
+    }
+  }
+
+  /**
+   * @brief Decode the given data to UTF-16.
+   *
+   * Invalid UTF-8 sequences are replaced by U+FFFD.
+   *
+   * @param data The data to decode (without BOM).
+   * @param size The size of the data.
+   * @param encoding The encoding of the data.
+   * @param out The output buffer, must have room for at least maxDecodedSize(encoding, size)
+   *     code units.
+   *
+   * @return the number of code units written.
+   */
+  inline std::size_t decode(const unsigned char* data, std::size_t size, Encoding encoding, char16_t* out) {
+    std::size_t n = 0;
+    switch (encoding) {
+    case Encoding::UTF16LE:
+      for (std::size_t i = 0; i + 1 < size; i += 2) {
+        out[n++] = static_cast<char16_t>(data[i] | (data[i + 1] << 8));
+      }
+      break;
+    case Encoding::UTF16BE:
+      for (std::size_t i = 0; i + 1 < size; i += 2) {
+        out[n++] = static_cast<char16_t>((data[i] << 8) | data[i + 1]);
+      }
+      break;
+    case Encoding::UTF8:
+      for (std::size_t i = 0; i < size; ) {
+        std::size_t ascii = details::asciiPrefix(data + i, size - i);
+        details::widenAscii(data + i, ascii, out + n);
+        i += ascii;
+        n += ascii;
+        if (i >= size) {
+          break;
+        }
+
+        char32_t codepoint;
+        std::size_t length = details::decodeUtf8(data + i, size - i, codepoint);
+        if (length == 0) {
+          out[n++] = 0xFFFD;
+          ++i;
+        }
+        else if (codepoint >= 0x10000) {
+          codepoint -= 0x10000;
+          out[n++] = static_cast<char16_t>(0xD800 + (codepoint >> 10));
+          out[n++] = static_cast<char16_t>(0xDC00 + (codepoint & 0x3FF));
+          i += length;
+        }
+        else {
+          out[n++] = static_cast<char16_t>(codepoint);
+          i += length;
+        }
+      }
+      break;
+    case Encoding::WINDOWS_1252:
+      for (std::size_t i = 0; i < size; ) {
+        std::size_t ascii = details::asciiPrefix(data + i, size - i);
+        details::widenAscii(data + i, ascii, out + n);
+        i += ascii;
+        n += ascii;
+        if (i >= size) {
+          break;
+        }
+        const unsigned char c = data[i++];
+        out[n++] = c < 0xA0 ? details::WINDOWS_1252_HIGH[c - 0x80] : c;
+      }
+      break;
+    }
+    return n;
+  }
+
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
+
+#endif
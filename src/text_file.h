@@ -0,0 +1,50 @@
+#ifndef TEXT_FILE_H
+#define TEXT_FILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "text_decoder.h"
+
+/**
+ * @brief Read and decode the content of the given text file.
+ *
+ * The file is memory-mapped when possible, and decoded directly into the returned
+ * string (see TextDecoder::detect for the detection of the encoding).
+ *
+ * @param file The file to read, must be open.
+ * @param xml true if the file is an XML file.
+ *
+ * @return the decoded content of the file.
+ */
+inline QString readTextFile(QFile& file, bool xml)
+{
+  const qint64 size = file.size();
+  if (size <= 0) {
+    return QString();
+  }
+
+  QByteArray buffer;
+  const uchar* data = file.map(0, size);
+  if (data == nullptr) {
+    file.seek(0);
+    buffer = file.readAll();
+    data = reinterpret_cast<const uchar*>(buffer.constData());
+  }
+
+  auto detection = TextDecoder::detect(data, size, xml);
+  const std::size_t length = size - detection.offset;
+
+  QString text(static_cast<int>(TextDecoder::maxDecodedSize(detection.encoding, length)), Qt::Uninitialized);
+  text.truncate(static_cast<int>(TextDecoder::decode(
+    data + detection.offset, length, detection.encoding, reinterpret_cast<char16_t*>(text.data()))));
+
+  if (buffer.isNull()) {
+    file.unmap(const_cast<uchar*>(data));
+  }
+
+  return text;
+}
+
+#endif
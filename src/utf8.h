@@ -0,0 +1,143 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "text_decoder.h"
+
+/**
+ * UTF-16 to UTF-8 transcoding (and back) for strings crossing the native/managed
+ * boundary, e.g. messages and paths from C# that are logged.
+ *
+ * Most of these strings are ASCII, so runs of ASCII characters are transcoded 16 code
+ * units at a time with SSE2 (when available), and only the remaining characters go
+ * through the scalar path. Decoding is done by TextDecoder, which already has the same
+ * fast path. This header does not depend on Qt or on the CLR.
+ */
+
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+namespace Utf8 {
+
+  namespace details {
+
+    /**
+     * @brief Narrow the leading ASCII code units of the given data.
+     *
+     * @return the number of code units narrowed (and bytes written).
+     */
+    inline std::size_t narrowAsciiPrefix(const char16_t* data, std::size_t size, char* out) {
+      std::size_t i = 0;
+#ifdef TEXT_DECODER_SSE2
+      const __m128i mask = _mm_set1_epi16(static_cast<short>(0xFF80));
+      const __m128i zero = _mm_setzero_si128();
+      for (; i + 16 <= size; i += 16) {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 8));
+        __m128i nonAscii = _mm_and_si128(_mm_or_si128(low, high), mask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, zero)) != 0xFFFF) {
+          break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+      }
+#endif
+      for (; i < size && data[i] < 0x80; ++i) {
+        out[i] = static_cast<char>(data[i]);
+      }
+      return i;
+    }
+
+  }
+
+  /**
+   * @return an upper bound on the number of bytes needed to encode size UTF-16 code
+   *     units.
+   */
+  inline std::size_t maxEncodedSize(std::size_t size) {
+    return 3 * size;
+  }
+
+  /**
+   * @brief Encode the given UTF-16 data to UTF-8.
+   *
+   * Unpaired surrogates are replaced by U+FFFD.
+   *
+   * @param data The data to encode.
+   * @param size The number of code units.
+   * @param out The output buffer, must have room for at least maxEncodedSize(size) bytes.
+   *
+   * @return the number of bytes written.
+   */
+  inline std::size_t encode(const char16_t* data, std::size_t size, char* out) {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < size; ) {
+      std::size_t ascii = details::narrowAsciiPrefix(data + i, size - i, out + n);
+      i += ascii;
+      n += ascii;
+      if (i >= size) {
+        break;
+      }
+
+      char32_t codepoint = data[i++];
+      if (codepoint >= 0xD800 && codepoint <= 0xDFFF) {
+        if (codepoint <= 0xDBFF && i < size && data[i] >= 0xDC00 && data[i] <= 0xDFFF) {
+          codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (data[i++] - 0xDC00);
+        }
+        else {
+          codepoint = 0xFFFD;
+        }
+      }
+
+      if (codepoint < 0x800) {
+        out[n++] = static_cast<char>(0xC0 | (codepoint >> 6));
+        out[n++] = static_cast<char>(0x80 | (codepoint & 0x3F));
+      }
+      else if (codepoint < 0x10000) {
+        out[n++] = static_cast<char>(0xE0 | (codepoint >> 12));
+        out[n++] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out[n++] = static_cast<char>(0x80 | (codepoint & 0x3F));
+      }
+      else {
+        out[n++] = static_cast<char>(0xF0 | (codepoint >> 18));
+        out[n++] = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out[n++] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out[n++] = static_cast<char>(0x80 | (codepoint & 0x3F));
+      }
+    }
+    return n;
+  }
+
+  /**
+   * @return an upper bound on the number of UTF-16 code units needed to decode size
+   *     bytes of UTF-8.
+   */
+  inline std::size_t maxDecodedSize(std::size_t size) {
+    return TextDecoder::maxDecodedSize(TextDecoder::Encoding::UTF8, size);
+  }
+
+  /**
+   * @brief Decode the given UTF-8 data to UTF-16.
+   *
+   * Invalid sequences are replaced by U+FFFD.
+   *
+   * @param data The data to decode.
+   * @param size The number of bytes.
+   * @param out The output buffer, must have room for at least maxDecodedSize(size) code
+   *     units.
+   *
+   * @return the number of code units written.
+   */
+  inline std::size_t decode(const char* data, std::size_t size, char16_t* out) {
+    return TextDecoder::decode(reinterpret_cast<const unsigned char*>(data), size, TextDecoder::Encoding::UTF8, out);
+  }
+
+}
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
+
+#endif
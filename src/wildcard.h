@@ -0,0 +1,285 @@
+#ifndef WILDCARD_H
+#define WILDCARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Case-insensitive wildcard matcher for file names.
+ *
+ * This follows the semantics of QDir::match(): the filter may contain multiple patterns
+ * separated by semicolons (or by spaces if the filter contains no semicolon), and a name
+ * matches if it matches any of them. Each
+ * pattern supports * (any sequence), ? (any character) and [...] sets (with ranges,
+ * negated with ! or ^).
+ *
+ * The filter is compiled once, and names are then matched as raw UTF-16 code units
+ * without allocating. Case-folding is done inline for ASCII and with a small table for
+ * Latin-1, Latin Extended-A, Greek and Cyrillic letters, which covers the names found in
+ * game data directories. This header does not depend on Qt or on the CLR.
+ */
+
+// Matching is done once per file of possibly large listings, keep it native:
+#ifdef _MANAGED
+#pragma managed(push, off)
+#endif
+
+class WildcardMatcher {
+public:
+
+  WildcardMatcher() = default;
+
+  /**
+   * @brief Compile the given filter.
+   *
+   * @param filter The filter, containing one or more patterns.
+   */
+  explicit WildcardMatcher(std::u16string_view filter) {
+    const char16_t separator = filter.find(u';') != std::u16string_view::npos ? u';' : u' ';
+    std::size_t start = 0;
+    for (std::size_t i = 0; i <= filter.size(); ++i) {
+      if (i == filter.size() || filter[i] == separator) {
+        std::u16string_view pattern = trim(filter.substr(start, i - start));
+        if (!pattern.empty()) {
+          compile(pattern);
+        }
+        start = i + 1;
+      }
+    }
+  }
+
+  /**
+   * @return true if the filter contains no pattern (in which case nothing matches).
+   */
+  bool empty() const { return m_Patterns.empty() && !m_MatchAll; }
+
+  /**
+   * @brief Check if the given name matches any of the patterns.
+   *
+   * @param name The name to match.
+   *
+   * @return true if the name matches.
+   */
+  bool matches(std::u16string_view name) const {
+    if (m_MatchAll) {
+      return true;
+    }
+    for (Pattern const& pattern : m_Patterns) {
+      if (matches(pattern, name)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Fold the case of the given character.
+   */
+  static char16_t fold(char16_t c) {
+    if (c < 0x80) {
+      return c >= u'A' && c <= u'Z' ? c + 0x20 : c;
+    }
+    // Latin-1 (except the multiplication sign):
+    if (c >= 0xC0 && c <= 0xDE && c != 0xD7) {
+      return c + 0x20;
+    }
+    // Latin Extended-A, pairs of upper/lower case letters:
+    if ((c >= 0x100 && c <= 0x137) || (c >= 0x14A && c <= 0x177)) {
+      return c | 1;
+    }
+    if ((c >= 0x139 && c <= 0x148) || (c >= 0x179 && c <= 0x17E)) {
+      return (c & 1) ? c + 1 : c;
+    }
+    // Greek (except the final sigma position):
+    if (c >= 0x391 && c <= 0x3AB && c != 0x3A2) {
+      return c + 0x20;
+    }
+    // Cyrillic:
+    if (c >= 0x410 && c <= 0x42F) {
+      return c + 0x20;
+    }
+    if (c >= 0x400 && c <= 0x40F) {
+      return c + 0x50;
+    }
+    return c;
+  }
+
+private:
+
+  enum class TokenType : std::uint8_t {
+    LITERAL,
+    ANY_CHARACTER,
+    ANY_SEQUENCE,
+    SET
+  };
+
+  struct Token {
+    TokenType type;
+
+    // Folded character for LITERAL, index of the first range for SET:
+    char16_t value;
+
+    // Number of ranges and negation for SET:
+    std::uint16_t count;
+    bool negated;
+  };
+
+  struct Range {
+    char16_t first, last;
+  };
+
+  struct Pattern {
+    std::vector<Token> tokens;
+  };
+
+  static std::u16string_view trim(std::u16string_view value) {
+    while (!value.empty() && value.front() == u' ') {
+      value.remove_prefix(1);
+    }
+    while (!value.empty() && value.back() == u' ') {
+      value.remove_suffix(1);
+    }
+    return value;
+  }
+
+  void compile(std::u16string_view pattern) {
+    Pattern compiled;
+    bool onlyStars = true;
+
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+      const char16_t c = pattern[i];
+
+      if (c == u'*') {
+        // Consecutive stars are equivalent to a single one:
+        if (compiled.tokens.empty() || compiled.tokens.back().type != TokenType::ANY_SEQUENCE) {
+          compiled.tokens.push_back({ TokenType::ANY_SEQUENCE, 0, 0, false });
+        }
+        continue;
+      }
+
+      onlyStars = false;
+      if (c == u'?') {
+        compiled.tokens.push_back({ TokenType::ANY_CHARACTER, 0, 0, false });
+      }
+      else if (c == u'[' && compileSet(pattern, i, compiled)) {
+        // i has been moved to the closing bracket.
+      }
+      else {
+        compiled.tokens.push_back({ TokenType::LITERAL, fold(c), 0, false });
+      }
+    }
+
+    if (onlyStars) {
+      m_MatchAll = true;
+    }
+    else {
+      m_Patterns.push_back(std::move(compiled));
+    }
+  }
+
+  /**
+   * @brief Compile the set starting at pattern[i], and move i to its closing bracket.
+   *
+   * @return false if the set is not closed, in which case the bracket is a literal.
+   */
+  bool compileSet(std::u16string_view pattern, std::size_t& i, Pattern& compiled) {
+    std::size_t j = i + 1;
+    bool negated = false;
+    if (j < pattern.size() && (pattern[j] == u'!' || pattern[j] == u'^')) {
+      negated = true;
+      ++j;
+    }
+
+    // A closing bracket right after the opening one is part of the set:
+    const std::size_t first = j;
+    while (j < pattern.size() && (pattern[j] != u']' || j == first)) {
+      ++j;
+    }
+    if (j >= pattern.size()) {
+      return false;
+    }
+
+    const std::size_t start = m_Ranges.size();
+    for (std::size_t k = first; k < j; ++k) {
+      if (k + 2 < j && pattern[k + 1] == u'-') {
+        m_Ranges.push_back({ pattern[k], pattern[k + 2] });
+        k += 2;
+      }
+      else {
+        m_Ranges.push_back({ pattern[k], pattern[k] });
+      }
+    }
+
+    compiled.tokens.push_back({ TokenType::SET, static_cast<char16_t>(start),
+      static_cast<std::uint16_t>(m_Ranges.size() - start), negated });
+    i = j;
+    return true;
+  }
+
+  bool inSet(Token const& token, char16_t c) const {
+    const char16_t folded = fold(c);
+    bool found = false;
+    for (std::size_t k = token.value; k < token.value + token.count && !found; ++k) {
+      Range const& range = m_Ranges[k];
+      found = (c >= range.first && c <= range.last)
+        || (folded >= fold(range.first) && folded <= fold(range.last));
+    }
+    return found != token.negated;
+  }
+
+  bool matches(Token const& token, char16_t c) const {
+    switch (token.type) {
+    case TokenType::LITERAL:
+      return token.value == fold(c);
+    case TokenType::ANY_CHARACTER:
+      return true;
+    case TokenType::SET:
+      return inSet(token, c);
+    default:
+      return false;
+    }
+  }
+
+  bool matches(Pattern const& pattern, std::u16string_view name) const {
+    std::vector<Token> const& tokens = pattern.tokens;
+
+    // Greedy matching, backtracking to the last star on mismatch (linear for patterns
+    // with a single star, which is the common case):
+    std::size_t i = 0, j = 0;
+    std::size_t star = tokens.size(), resume = 0;
+    while (i < name.size()) {
+      if (j < tokens.size() && tokens[j].type == TokenType::ANY_SEQUENCE) {
+        star = j++;
+        resume = i;
+      }
+      else if (j < tokens.size() && matches(tokens[j], name[i])) {
+        ++i;
+        ++j;
+      }
+      else if (star != tokens.size()) {
+        j = star + 1;
+        i = ++resume;
+      }
+      else {
+        return false;
+      }
+    }
+
+    while (j < tokens.size() && tokens[j].type == TokenType::ANY_SEQUENCE) {
+      ++j;
+    }
+    return j == tokens.size();
+  }
+
+  std::vector<Pattern> m_Patterns;
+  std::vector<Range> m_Ranges;
+  bool m_MatchAll = false;
+};
+
+#ifdef _MANAGED
+#pragma managed(pop)
+#endif
+
+#endif
@@ -2,15 +2,15 @@
 #define XML_INFO_READER_H
 
 #include <QString>
-#include <QIODevice>
+#include <QStringList>
 #include <QXmlStreamReader>
-#include <QTextStream>
 #include <QFile>
-#include <QTextCodec>
 
 #include "utility.h"
 #include "log.h"
 
+#include "text_file.h"
+
 // This is from installer_fomod, but should probably not be duplicated here.
 
 struct FomodInfoReader: QObject {
@@ -23,112 +23,156 @@ public:
     XmlParseError(const QString& message): MyException(message) {}
   };
 
-  static QByteArray skipXmlHeader(QIODevice& file)
+  /**
+   * @brief Remove the XML declaration from the given (decoded) text.
+   *
+   * @return the text without its first line if it is a processing instruction.
+   */
+  static QString skipXmlHeader(QString const& text)
   {
-    static const unsigned char UTF16LE_BOM[] = { 0xFF, 0xFE };
-    static const unsigned char UTF16BE_BOM[] = { 0xFE, 0xFF };
-    static const unsigned char UTF8_BOM[] = { 0xEF, 0xBB, 0xBF };
-    static const unsigned char UTF16LE[] = { 0x3C, 0x00, 0x3F, 0x00 };
-    static const unsigned char UTF16BE[] = { 0x00, 0x3C, 0x00, 0x3F };
-    static const unsigned char UTF8[] = { 0x3C, 0x3F, 0x78, 0x6D };
-
-    file.seek(0);
-    QByteArray rawBytes = file.read(4);
-    QTextStream stream(&file);
-    int bom = 0;
-    if (rawBytes.startsWith((const char*)UTF16LE_BOM)) {
-      stream.setCodec("UTF16-LE");
-      bom = 2;
-    }
-    else if (rawBytes.startsWith((const char*)UTF16BE_BOM)) {
-      stream.setCodec("UTF16-BE");
-      bom = 2;
-    }
-    else if (rawBytes.startsWith((const char*)UTF8_BOM)) {
-      stream.setCodec("UTF-8");
-      bom = 3;
-    }
-    else if (rawBytes.startsWith(QByteArray((const char*)UTF16LE, 4))) {
-      stream.setCodec("UTF16-LE");
-    }
-    else if (rawBytes.startsWith(QByteArray((const char*)UTF16BE, 4))) {
-      stream.setCodec("UTF16-BE");
-    }
-    else if (rawBytes.startsWith(QByteArray((const char*)UTF8, 4))) {
-      stream.setCodec("UTF-8");
-    } // otherwise maybe the textstream knows the encoding?
-
-    stream.seek(bom);
-    QString header = stream.readLine();
-    if (!header.startsWith("<?")) {
+    if (!text.startsWith("<?")) {
       // it was all for nothing, there is no header here...
-      stream.seek(bom);
+      return text;
     }
-    // this seems to be necessary due to buffering in QTextStream
-    file.seek(stream.pos());
-    return file.readAll();
+    int end = text.indexOf('\n');
+    return end == -1 ? QString() : text.mid(end + 1);
   }
 
   template <class Fn>
   static auto readXml(QFile& file, Fn &&fn)
   {
-    // List of encodings to try:
-    static const std::vector<const char*> encodings{ "utf-16", "utf-8", "iso-8859-1" };
+    // The file is decoded once, the reader then ignores the encoding declaration:
+    const QString text = readTextFile(file, true);
 
-    std::string errorMessage;
     try {
-      QXmlStreamReader reader(&file);
+      QXmlStreamReader reader(text);
       return fn(reader);
     }
     catch (const XmlParseError& e) {
-      MOBase::log::warn("The {} in this file is incorrectly encoded ({}). Applying heuristics...", file.fileName(), e.what());
+      MOBase::log::warn("Failed to parse {} ({}). Applying heuristics...", file.fileName(), e.what());
     }
 
     // nmm's xml parser is less strict than the one from qt and allows files with
-    // wrong encoding in the header. Being strict here would be bad user experience
-    // this works around bad headers.
-    QByteArray headerlessData = skipXmlHeader(file);
-
-    // try parsing the file with several encodings to support broken files
-    for (auto encoding : encodings) {
-      MOBase::log::debug("Trying encoding {} for {}... ", encoding, file.fileName());
-      try {
-        QTextCodec* codec = QTextCodec::codecForName(encoding);
-        QXmlStreamReader reader(codec->fromUnicode(QString("<?xml version=\"1.0\" encoding=\"%1\" ?>").arg(encoding)) + headerlessData);
-        MOBase::log::debug("Interpreting {} as {}.", file.fileName(), encoding);
-        return fn(reader);
-      }
-      catch (const XmlParseError& e) {
-        MOBase::log::debug("Not {}: {}.", encoding, e.what());
-      }
+    // a broken header. Being strict here would be bad user experience, so this
+    // works around bad headers.
+    try {
+      QXmlStreamReader reader(skipXmlHeader(text));
+      return fn(reader);
+    }
+    catch (const XmlParseError& e) {
+      MOBase::log::debug("Parsing {} without header failed: {}.", file.fileName(), e.what());
     }
-    
+
     throw XmlParseError(tr("Failed to parse %1. See console for details.").arg(file.fileName()));
   }
 
-  static std::tuple<QString, int, QString> parseInfo(QXmlStreamReader& reader)
+  /**
+   * Content of a fomod/info.xml file.
+   */
+  struct FomodInfo {
+    QString name;
+    QString author;
+    QString version;
+    int id = -1;
+    QString website;
+    QStringList groups;
+  };
+
+  /**
+   * Fields of FomodInfo, to specify which ones must be parsed.
+   */
+  enum InfoField {
+    NAME = 0x01,
+    AUTHOR = 0x02,
+    VERSION = 0x04,
+    ID = 0x08,
+    WEBSITE = 0x10,
+    GROUPS = 0x20,
+    ALL_FIELDS = 0x3F
+  };
+
+  /**
+   * @brief Parse the content of an info.xml file.
+   *
+   * Parsing stops as soon as all the requested fields have been read, and the content of
+   * other elements is skipped without being read. Errors after the requested fields are
+   * thus not reported.
+   *
+   * @param reader The reader to parse from.
+   * @param fields The fields to parse (combination of InfoField).
+   *
+   * @return the parsed information, fields not found (or not requested) are left empty.
+   */
+  static FomodInfo parseInfo(QXmlStreamReader& reader, int fields = ALL_FIELDS)
   {
-    std::tuple<QString, int, QString> info{ "", -1, "" };
-    while (!reader.atEnd()) {
-      switch (reader.readNext()) {
-      case QXmlStreamReader::StartElement: {
-        if (reader.name() == "Name") {
-          std::get<0>(info) = reader.readElementText();
-        }
-        else if (reader.name() == "Author") {
-        }
-        else if (reader.name() == "Version") {
-          std::get<2>(info) = reader.readElementText();
-        }
-        else if (reader.name() == "Id") {
-          std::get<1>(info) = reader.readElementText().toInt();
-        }
-        else if (reader.name() == "Website") {
-        }
+    FomodInfo info;
+    int remaining = fields & ALL_FIELDS;
+
+    // Find the root element:
+    if (!reader.readNextStartElement()) {
+      remaining = 0;
+    }
+
+    while (remaining != 0 && reader.readNextStartElement()) {
+      int field = 0;
+      if (reader.name() == "Name") {
+        field = NAME;
+      }
+      else if (reader.name() == "Author") {
+        field = AUTHOR;
+      }
+      else if (reader.name() == "Version") {
+        field = VERSION;
+      }
+      else if (reader.name() == "Id") {
+        field = ID;
+      }
+      else if (reader.name() == "Website") {
+        field = WEBSITE;
+      }
+      else if (reader.name() == "Groups") {
+        field = GROUPS;
+      }
+
+      // Not a field we are interested in (or already read):
+      if ((field & remaining) == 0) {
+        reader.skipCurrentElement();
+        continue;
+      }
+
+      switch (field) {
+      case NAME:
+        info.name = reader.readElementText();
+        break;
+      case AUTHOR:
+        info.author = reader.readElementText();
+        break;
+      case VERSION:
+        info.version = reader.readElementText();
+        break;
+      case ID: {
+        bool ok;
+        int id = reader.readElementText().toInt(&ok);
+        info.id = ok ? id : -1;
       } break;
-      default: {} break;
+      case WEBSITE:
+        info.website = reader.readElementText();
+        break;
+      case GROUPS:
+        while (reader.readNextStartElement()) {
+          if (reader.name() == "element") {
+            info.groups.append(reader.readElementText());
+          }
+          else {
+            reader.skipCurrentElement();
+          }
+        }
+        break;
       }
+
+      remaining &= ~field;
     }
+
     if (reader.hasError()) {
       throw XmlParseError(QString("%1 in line %2").arg(reader.errorString()).arg(reader.lineNumber()));
     }
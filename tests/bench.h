@@ -0,0 +1,34 @@
+#ifndef TESTS_BENCH_H
+#define TESTS_BENCH_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+/**
+ * Minimal benchmark helper: measure() runs a function a given number of times (after a
+ * warm-up run) and prints the average duration of a run. The function returns a value
+ * derived from its work, so that the work cannot be optimized away.
+ */
+
+inline volatile std::size_t& benchmarkSink() {
+  static volatile std::size_t sink = 0;
+  return sink;
+}
+
+template <class Fn>
+double measure(const char* name, int iterations, Fn&& fn) {
+  benchmarkSink() += static_cast<std::size_t>(fn());
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    benchmarkSink() += static_cast<std::size_t>(fn());
+  }
+  const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+  const double average = elapsed.count() / iterations;
+  std::printf("%-48s %12.1f us\n", name, average);
+  return average;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <cstdio>
+
+/**
+ * Minimal test helpers: CHECK() reports the failed conditions, and main() returns
+ * testResult().
+ */
+
+inline int& testFailures() {
+  static int failures = 0;
+  return failures;
+}
+
+inline int testResult() {
+  if (testFailures() != 0) {
+    std::fprintf(stderr, "%d check(s) failed.\n", testFailures());
+  }
+  return testFailures() == 0 ? 0 : 1;
+}
+
+#define CHECK(condition)                                                              \
+  do {                                                                                \
+    if (!(condition)) {                                                               \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed.\n", __FILE__, __LINE__, #condition); \
+      ++testFailures();                                                               \
+    }                                                                                 \
+  } while (false)
+
+#endif
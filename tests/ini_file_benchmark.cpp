@@ -0,0 +1,94 @@
+#include "ini_file.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QFile>
+#include <QSettings>
+#include <QString>
+#include <QTemporaryDir>
+
+#include "bench.h"
+
+/**
+ * Read and edit a 2000-entry INI file with IniDocument and with QSettings (used before).
+ */
+int main() {
+  QTemporaryDir directory;
+  const QString path = directory.filePath("Skyrim.ini");
+
+  std::string text;
+  std::vector<std::pair<std::string, std::string>> keys;
+  for (int i = 0; i < 40; ++i) {
+    const std::string section = "Section" + std::to_string(i);
+    text += "[" + section + "]\r\n";
+    for (int j = 0; j < 50; ++j) {
+      const std::string key = "fSetting" + std::to_string(j);
+      text += key + "=" + std::to_string(i * j) + ".0000\r\n";
+      keys.emplace_back(section, key);
+    }
+    text += "\r\n";
+  }
+
+  auto write = [&] {
+    QFile file(path);
+    file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    file.write(text.data(), text.size());
+  };
+  write();
+
+  auto readFile = [&] {
+    QFile file(path);
+    file.open(QIODevice::ReadOnly);
+    return file.readAll().toStdString();
+  };
+
+  // Look-ups of 100 values, QSettings parses the whole file when opened:
+  const double settingsRead = measure("QSettings, open and read 100 values", 20, [&] {
+    QSettings settings(path, QSettings::IniFormat);
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < keys.size(); i += keys.size() / 100) {
+      count += settings.value(QString::fromStdString(keys[i].first + "/" + keys[i].second)).isValid();
+    }
+    return count;
+  });
+  const double documentRead = measure("IniDocument, parse and read 100 values", 20, [&] {
+    const std::string content = readFile();
+    IniDocument document(content);
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < keys.size(); i += keys.size() / 100) {
+      count += document.find(keys[i].first, keys[i].second) != nullptr;
+    }
+    return count;
+  });
+
+  // Edits of 10 values, written back to the file:
+  const double settingsWrite = measure("QSettings, edit 10 values", 20, [&] {
+    write();
+    QSettings settings(path, QSettings::IniFormat);
+    for (int i = 0; i < 10; ++i) {
+      settings.setValue(QString("Section%1/fSetting%1").arg(i), "1.0000");
+    }
+    settings.sync();
+    return settings.status() == QSettings::NoError;
+  });
+  const double documentWrite = measure("IniDocument, edit 10 values", 20, [&] {
+    write();
+    const std::string content = readFile();
+    std::vector<IniDocument::Edit> edits;
+    for (int i = 0; i < 10; ++i) {
+      edits.push_back({ "Section" + std::to_string(i), "fSetting" + std::to_string(i), "1.0000" });
+    }
+    std::string output;
+    if (IniDocument(content).apply(edits, output)) {
+      QFile file(path);
+      file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+      file.write(output.data(), output.size());
+    }
+    return output.size();
+  });
+
+  std::printf("Speed-up: %.1fx (read), %.1fx (edit)\n", settingsRead / documentRead, settingsWrite / documentWrite);
+  return 0;
+}
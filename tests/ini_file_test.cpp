@@ -0,0 +1,124 @@
+#include "ini_file.h"
+
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+/**
+ * @return the text after applying the given edits, or the original text if apply()
+ *     reports that nothing changes.
+ */
+static std::string apply(std::string const& text, std::vector<IniDocument::Edit> const& edits) {
+  std::string output = text;
+  IniDocument(text).apply(edits, output);
+  return output;
+}
+
+static bool changes(std::string const& text, std::vector<IniDocument::Edit> const& edits) {
+  std::string output;
+  return IniDocument(text).apply(edits, output);
+}
+
+static std::string value(std::string const& text, std::string_view section, std::string_view key) {
+  IniDocument document(text);
+  auto entry = document.find(section, key);
+  return entry == nullptr ? "<none>" : std::string(entry->value);
+}
+
+int main() {
+
+  const std::string ini =
+    "; Skyrim.ini\r\n"
+    "sTop=1\r\n"
+    "\r\n"
+    "[General]\r\n"
+    "sLanguage = ENGLISH ; comment\r\n"
+    "sPath=\"a;b\"\r\n"
+    "  uGridsToLoad=5\r\n"
+    "\r\n"
+    "[Display]\r\n"
+    "iSize H=1080\r\n"
+    "bEmpty=\r\n"
+    "sLanguage=dup\r\n"
+    "sLanguage=second\r\n";
+
+  // Parsing, with case-insensitive look-ups and the first occurrence of a key:
+  CHECK(value(ini, "", "sTop") == "1");
+  CHECK(value(ini, "general", "SLANGUAGE") == "ENGLISH");
+  CHECK(value(ini, "General", "sPath") == "\"a;b\"");
+  CHECK(value(ini, "General", "uGridsToLoad") == "5");
+  CHECK(value(ini, "Display", "iSize H") == "1080");
+  CHECK(value(ini, "Display", "bEmpty") == "");
+  CHECK(value(ini, "Display", "sLanguage") == "dup");
+  CHECK(value(ini, "Display", "sTop") == "<none>");
+
+  // No-op: no edit, or edits with the current values:
+  CHECK(!changes(ini, {}));
+  CHECK(!changes(ini, { { "General", "sLanguage", "ENGLISH" }, { "", "sTop", "1" } }));
+  CHECK(!changes(ini, { { "DISPLAY", "ISIZE H", "1080" } }));
+
+  // In-place edits keep the formatting, comments and line endings:
+  CHECK(apply(ini, { { "General", "sLanguage", "FRENCH" }, { "Display", "bEmpty", "0" }, { "", "sTop", "2" } })
+    == "; Skyrim.ini\r\n"
+       "sTop=2\r\n"
+       "\r\n"
+       "[General]\r\n"
+       "sLanguage = FRENCH ; comment\r\n"
+       "sPath=\"a;b\"\r\n"
+       "  uGridsToLoad=5\r\n"
+       "\r\n"
+       "[Display]\r\n"
+       "iSize H=1080\r\n"
+       "bEmpty=0\r\n"
+       "sLanguage=dup\r\n"
+       "sLanguage=second\r\n");
+
+  // The last edit of a key wins:
+  CHECK(apply("[A]\nk=1\n", { { "A", "k", "2" }, { "a", "K", "3" } }) == "[A]\nk=3\n");
+
+  // New keys at the end of their section (before the blank lines), new sections at the
+  // end of the file, with the line endings of the file:
+  CHECK(apply(ini, { { "General", "bNew", "1" }, { "Audio", "fVolume", "0.5" }, { "Audio", "fMusic", "1" }, { "", "sNewTop", "x" } })
+    == "; Skyrim.ini\r\n"
+       "sTop=1\r\n"
+       "sNewTop=x\r\n"
+       "\r\n"
+       "[General]\r\n"
+       "sLanguage = ENGLISH ; comment\r\n"
+       "sPath=\"a;b\"\r\n"
+       "  uGridsToLoad=5\r\n"
+       "bNew=1\r\n"
+       "\r\n"
+       "[Display]\r\n"
+       "iSize H=1080\r\n"
+       "bEmpty=\r\n"
+       "sLanguage=dup\r\n"
+       "sLanguage=second\r\n"
+       "\r\n"
+       "[Audio]\r\n"
+       "fVolume=0.5\r\n"
+       "fMusic=1\r\n");
+
+  // Files without a trailing line break:
+  CHECK(apply("[A]\nk=1", { { "A", "j", "2" } }) == "[A]\nk=1\nj=2\n");
+  CHECK(apply("[A]\nk=1", { { "B", "j", "2" } }) == "[A]\nk=1\n\n[B]\nj=2\n");
+
+  // Empty files:
+  CHECK(apply("", { { "A", "k", "1" } }) == "[A]\nk=1\n");
+  CHECK(apply("", { { "", "k", "1" } }) == "k=1\n");
+
+  // UTF-8 BOM, skipped when parsing and kept when writing:
+  const std::string bom = "\xEF\xBB\xBF";
+  CHECK(IniDocument(bom + "[A]\n").hasUtf8Bom());
+  CHECK(!IniDocument(ini).hasUtf8Bom());
+  CHECK(value(bom + "[General]\nk=1\n", "General", "k") == "1");
+  CHECK(value(bom + "k=1\n", "", "k") == "1");
+  CHECK(!changes(bom + "[General]\nk=1\n", { { "General", "k", "1" } }));
+  CHECK(apply(bom + "[General]\nk=1\n", { { "General", "k", "2" } }) == bom + "[General]\nk=2\n");
+  CHECK(apply(bom + "[General]\nk=1\n", { { "General", "j", "2" } }) == bom + "[General]\nk=1\nj=2\n");
+  CHECK(apply(bom + "[General]\nk=1\n", { { "", "j", "2" } }) == bom + "j=2\n[General]\nk=1\n");
+  CHECK(apply(bom, { { "A", "k", "1" } }) == bom + "[A]\nk=1\n");
+
+  return testResult();
+}
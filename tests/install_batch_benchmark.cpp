@@ -0,0 +1,49 @@
+#include "install_batch.h"
+
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "memory_tree.h"
+
+using namespace MOBase;
+
+/**
+ * Install 10k files from 100 folders, one by one with IFileTree::copy() (as with
+ * InstallFileFromMod) or as a single batch (as with InstallFilesFromMod).
+ */
+int main() {
+  constexpr int folders = 100;
+  constexpr int files = 100;
+  constexpr int iterations = 20;
+
+  auto source = MemoryTree::create();
+  std::vector<std::pair<std::shared_ptr<const FileTreeEntry>, QString>> entries;
+  for (int i = 0; i < folders; ++i) {
+    for (int j = 0; j < files; ++j) {
+      QString path = QString("Textures/Armor/Set%1/Part%2.dds").arg(i).arg(j);
+      entries.emplace_back(source->addFile(path), "Data/" + path);
+    }
+  }
+
+  const double single = measure("IFileTree::copy(), one call per file", iterations, [&] {
+    auto tree = MemoryTree::create();
+    std::size_t count = 0;
+    for (auto const& [entry, to] : entries) {
+      count += tree->copy(entry, to) != nullptr;
+    }
+    return count;
+  });
+
+  const double batched = measure("InstallBatch::apply()", iterations, [&] {
+    auto tree = MemoryTree::create();
+    InstallBatch batch;
+    for (auto const& [entry, to] : entries) {
+      batch.add(entry, to);
+    }
+    return batch.apply(tree, [](std::size_t, std::shared_ptr<FileTreeEntry> const&) { });
+  });
+
+  std::printf("Speed-up: %.2fx\n", single / batched);
+  return 0;
+}
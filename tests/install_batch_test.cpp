@@ -0,0 +1,54 @@
+#include "install_batch.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "check.h"
+#include "memory_tree.h"
+
+using namespace MOBase;
+
+int main() {
+  auto source = MemoryTree::create();
+  auto plugin = source->addFile("Plugin.esp");
+  auto armor = source->addFile("Textures/Armor.dds");
+  auto helmet = source->addFile("Textures/Helmet.dds");
+  auto meshes = source->addDirectory("Meshes");
+  meshes->addFile("Armor.nif");
+
+  InstallBatch batch;
+  batch.add(plugin, "");
+  batch.add(armor, "textures/armor/Armor.dds");
+  batch.add(helmet, "Textures\\Armor\\");
+  batch.add(meshes, "Meshes/");
+  batch.add(plugin, "Optional/Renamed.esp");
+  batch.add(helmet, "TEXTURES/ARMOR/Armor.dds");
+  CHECK(batch.size() == 6);
+
+  auto tree = MemoryTree::create();
+  std::vector<std::size_t> copied;
+  const int count = batch.apply(tree, [&](std::size_t i, std::shared_ptr<FileTreeEntry> const& copy) {
+    CHECK(copy != nullptr);
+    copied.push_back(i);
+  });
+
+  // The last entry has the same destination as the second one:
+  CHECK(count == 5);
+  CHECK(copied.size() == 5);
+  CHECK(std::find(copied.begin(), copied.end(), 5) == copied.end());
+
+  CHECK(tree->find("Plugin.esp") != nullptr);
+  CHECK(tree->find("Textures/Armor/Armor.dds") != nullptr);
+  CHECK(tree->find("Textures/Armor/Helmet.dds") != nullptr);
+  CHECK(tree->find("Meshes/Armor.nif") != nullptr);
+  CHECK(tree->find("Optional/Renamed.esp") != nullptr);
+
+  // The source is copied, not moved:
+  CHECK(source->find("Textures/Armor.dds") == armor);
+
+  // Each destination directory is created once, whatever the case or separators:
+  CHECK(tree->find("Textures")->astree()->size() == 1);
+  CHECK(tree->find("Textures/Armor")->astree()->size() == 2);
+
+  return testResult();
+}
@@ -0,0 +1,37 @@
+#ifndef TESTS_MEMORY_TREE_H
+#define TESTS_MEMORY_TREE_H
+
+#include <memory>
+#include <vector>
+
+#include "ifiletree.h"
+
+/**
+ * @brief In-memory file tree, populated through IFileTree::addFile/addDirectory.
+ */
+class MemoryTree : public MOBase::IFileTree {
+public:
+
+  static std::shared_ptr<MemoryTree> create() {
+    return std::shared_ptr<MemoryTree>(new MemoryTree(nullptr, ""));
+  }
+
+protected:
+
+  MemoryTree(std::shared_ptr<const IFileTree> parent, QString name) :
+    FileTreeEntry(parent, name), IFileTree() { }
+
+  std::shared_ptr<IFileTree> makeDirectory(std::shared_ptr<const IFileTree> parent, QString name) const override {
+    return std::shared_ptr<MemoryTree>(new MemoryTree(parent, name));
+  }
+
+  bool doPopulate(std::shared_ptr<const IFileTree>, std::vector<std::shared_ptr<MOBase::FileTreeEntry>>&) const override {
+    return true;
+  }
+
+  std::shared_ptr<IFileTree> doClone() const override {
+    return std::shared_ptr<MemoryTree>(new MemoryTree(nullptr, name()));
+  }
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "psettings.h"
+
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+#include "bench.h"
+
+/**
+ * Store, look up and format 1000 values with PSettings and with the sorted map of
+ * (section, key) pairs used before, as a QMap.
+ */
+
+// The previous implementation of PSettings:
+struct MapSettings {
+  void setValue(QString section, QString key, QString value) {
+    m_Values[qMakePair(section, key)] = value;
+  }
+
+  QString value(QString section, QString key) const {
+    return m_Values.value(qMakePair(section, key));
+  }
+
+  QString toString() const {
+    QString result;
+    QString cSection;
+    for (auto it = m_Values.begin(); it != m_Values.end(); ++it) {
+      if (cSection != it.key().first) {
+        if (!cSection.isEmpty()) {
+          result += '\n';
+        }
+        cSection = it.key().first;
+        result += "[" + cSection + "]\n";
+      }
+      result += it.key().second + "=" + it.value() + "\n";
+    }
+    return result;
+  }
+
+  QMap<QPair<QString, QString>, QString> m_Values;
+};
+
+int main() {
+  QStringList sections, keys;
+  for (int i = 0; i < 20; ++i) {
+    sections.append(QString("Section%1").arg(i));
+  }
+  for (int i = 0; i < 50; ++i) {
+    keys.append(QString("fSetting%1").arg(i));
+  }
+
+  auto run = [&](auto& settings) {
+    for (QString const& section : sections) {
+      for (QString const& key : keys) {
+        settings.setValue(section, key, key);
+      }
+    }
+
+    std::size_t size = 0;
+    for (int n = 0; n < 10; ++n) {
+      for (QString const& section : sections) {
+        for (QString const& key : keys) {
+          size += settings.value(section, key).size();
+        }
+      }
+    }
+    return size + settings.toString().size();
+  };
+
+  const double map = measure("QMap of (section, key)", 20, [&] {
+    MapSettings settings;
+    return run(settings);
+  });
+  const double psettings = measure("PSettings", 20, [&] {
+    PSettings settings;
+    return run(settings);
+  });
+
+  std::printf("Speed-up: %.1fx\n", map / psettings);
+  return 0;
+}
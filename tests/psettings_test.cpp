@@ -0,0 +1,82 @@
+#include "psettings.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include "check.h"
+
+static QByteArray read(QString const& path) {
+  QFile file(path);
+  return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+static void write(QString const& path, QByteArray const& content) {
+  QFile file(path);
+  if (file.open(QIODevice::WriteOnly)) {
+    file.write(content);
+  }
+}
+
+int main() {
+
+  // Case-insensitive sections and keys, keeping the case of the first insertion:
+  PSettings settings;
+  CHECK(settings.empty());
+  settings.setValue("Display", "iSize H", "1080");
+  settings.setValue("General", "sLanguage", "ENGLISH");
+  settings.setValue("DISPLAY", "bFull Screen", "1");
+  settings.setValue("display", "ISIZE H", "720");
+  CHECK(!settings.empty());
+  CHECK(settings.value("display", "isize h") == "720");
+  CHECK(settings.hasValue("GENERAL", "SLANGUAGE"));
+  CHECK(!settings.hasValue("General", "iSize H"));
+  CHECK(settings.value("Audio", "fVolume").isEmpty());
+
+  // Insertion order:
+  CHECK(settings.toString() == "[Display]\niSize H=720\nbFull Screen=1\n\n[General]\nsLanguage=ENGLISH\n");
+  QStringList visited;
+  settings.forEach([&](QString const& section, QString const& key, QString const& value) {
+    visited.append(section + "/" + key + "=" + value);
+  });
+  CHECK(visited == QStringList({ "Display/iSize H=720", "Display/bFull Screen=1", "General/sLanguage=ENGLISH" }));
+
+  QTemporaryDir dir;
+  CHECK(dir.isValid());
+
+  // Update, keeping the formatting of the file:
+  const QString path = dir.filePath("Skyrim.ini");
+  write(path, "; comment\r\n[Display]\r\niSize H = 1080 ; height\r\n\r\n[General]\r\nsLanguage=ENGLISH\r\n");
+  CHECK(settings.update(path));
+  CHECK(read(path) == "; comment\r\n[Display]\r\niSize H = 720 ; height\r\nbFull Screen=1\r\n\r\n[General]\r\nsLanguage=ENGLISH\r\n");
+
+  // Nothing changes:
+  const QByteArray before = read(path);
+  CHECK(settings.update(path));
+  CHECK(read(path) == before);
+
+  // New file:
+  const QString newPath = dir.filePath("New.ini");
+  PSettings single;
+  single.setValue("Audio", "fVolume", "0.5");
+  CHECK(single.update(newPath));
+  CHECK(read(newPath) == "[Audio]\nfVolume=0.5\n");
+
+  // The General section covers the keys before the first section, as when reading:
+  const QString topPath = dir.filePath("Top.ini");
+  write(topPath, "sTop=1\n[Display]\nk=1\n");
+  PSettings general;
+  general.setValue("General", "sTop", "2");
+  general.setValue("General", "sOther", "3");
+  CHECK(general.update(topPath));
+  CHECK(read(topPath) == "sTop=2\n[Display]\nk=1\n\n[General]\nsOther=3\n");
+
+  // UTF-8 BOM:
+  const QString bomPath = dir.filePath("Bom.ini");
+  write(bomPath, "\xEF\xBB\xBF[General]\nsName=a\n");
+  PSettings bom;
+  bom.setValue("General", "sName", QString::fromUtf8("\xC3\xA9t\xC3\xA9"));
+  CHECK(bom.update(bomPath));
+  CHECK(read(bomPath) == "\xEF\xBB\xBF[General]\nsName=\xC3\xA9t\xC3\xA9\n");
+
+  return testResult();
+}
@@ -0,0 +1,95 @@
+#include "script_rewriter.h"
+
+#include <regex>
+#include <string>
+
+#include "bench.h"
+
+using namespace CSharp;
+
+/**
+ * Rewrite scripts of increasing sizes with the single-pass lexer and with the regular
+ * expressions used before (the .NET expressions of NMM, ported to std::regex since the
+ * tests do not use the CLR, with \b instead of the unsupported look-behind).
+ */
+
+static std::string regexRewrite(std::string const& script) {
+  static const std::regex scriptClass(R"re((class\s+Script\s*:.*?)(\S*BaseScript))re");
+  static const std::regex fommUsing(R"re(\s*using\s*fomm.Scripting\s*;)re");
+
+  std::smatch match;
+  std::string baseScript;
+  if (std::regex_search(script, match, scriptClass)) {
+    baseScript = match[2].str();
+  }
+
+  const std::regex otherScriptClasses("(class\\s+\\S+\\s*:.*?)\\b" + baseScript);
+  std::string code = std::regex_replace(script, scriptClass, "$1BaseScript");
+  code = std::regex_replace(code, otherScriptClasses, "$1BaseScript");
+  return std::regex_replace(code, fommUsing, "");
+}
+
+/**
+ * @return a script with the given number of methods, similar to the scripts found in
+ *     mods (comments, literals, calls to the script API).
+ */
+static std::string makeScript(int methods) {
+  std::string script =
+    "using System;\r\n"
+    "using System.Collections.Generic;\r\n"
+    "using System.Windows.Forms;\r\n"
+    "using fomm.Scripting;\r\n"
+    "\r\n"
+    "class Helper : FalloutNewVegasBaseScript {\r\n"
+    "  public static bool IsInstalled(string plugin) { return GetPluginList() != null; }\r\n"
+    "}\r\n"
+    "\r\n"
+    "class Script : FalloutNewVegasBaseScript {\r\n"
+    "  // Entry point of the script, called by the installer.\r\n"
+    "  public static bool OnActivate() {\r\n"
+    "    PerformBasicInstall();\r\n"
+    "    return true;\r\n"
+    "  }\r\n";
+
+  for (int i = 0; i < methods; ++i) {
+    const std::string n = std::to_string(i);
+    script +=
+      "\r\n"
+      "  /* Install the optional files of option " + n + ", see readme.txt. */\r\n"
+      "  static void InstallOption" + n + "(bool hd) {\r\n"
+      "    string folder = hd ? @\"Options\\HD\\" + n + "\" : \"Options\\\\SD\\\\" + n + "\";\r\n"
+      "    foreach (string file in GetModFileList()) {\r\n"
+      "      if (file.StartsWith(folder) && !file.EndsWith(\".txt\")) {\r\n"
+      "        InstallFileFromMod(file, file.Substring(folder.Length + 1));\r\n"
+      "      }\r\n"
+      "    }\r\n"
+      "    if (!DataFileExists(\"Option" + n + ".esp\")) {\r\n"
+      "      MessageBox(\"Option " + n + " requires the main plugin.\", \"Warning\");\r\n"
+      "    }\r\n"
+      "    EditINI(\"Display\", \"iShadowMapResolution\", (hd ? 4096 : 2048).ToString());\r\n"
+      "  }\r\n";
+  }
+
+  return script + "}\r\n";
+}
+
+int main() {
+  for (int methods : { 10, 100, 1000 }) {
+    const std::string script = makeScript(methods);
+    const int iterations = methods >= 1000 ? 5 : 50;
+    std::printf("Script of %zu bytes:\n", script.size());
+    if (regexRewrite(script) != rewriteScript(std::string_view(script))) {
+      std::printf("  The rewritten scripts differ.\n");
+    }
+
+    const double regex = measure("  regular expressions", iterations, [&] {
+      return regexRewrite(script).size();
+    });
+    const double lexer = measure("  single-pass lexer", iterations, [&] {
+      return rewriteScript(std::string_view(script)).size();
+    });
+
+    std::printf("  Speed-up: %.1fx\n", regex / lexer);
+  }
+  return 0;
+}
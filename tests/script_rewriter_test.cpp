@@ -0,0 +1,67 @@
+#include "script_rewriter.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "check.h"
+
+using namespace CSharp;
+
+static std::string rewrite(std::string_view source) {
+  return rewriteScript(source);
+}
+
+int main() {
+
+  // Base class of the Script class, qualified or not:
+  CHECK(rewrite("class Script : fomm.Scripting.FalloutNewVegasBaseScript { }")
+    == "class Script : BaseScript { }");
+  CHECK(rewrite("class Script : SkyrimBaseScript { }") == "class Script : BaseScript { }");
+  CHECK(rewrite("class Script : global::fomm.Scripting.BaseScript { }") == "class Script : BaseScript { }");
+
+  // Other classes deriving from the same base, but not from other bases:
+  CHECK(rewrite("class Script : FalloutBaseScript { } class Helper : FalloutBaseScript { } class Other : Form { }")
+    == "class Script : BaseScript { } class Helper : BaseScript { } class Other : Form { }");
+
+  // Interfaces after the base class, generic classes and constraints:
+  CHECK(rewrite("class Script : FalloutBaseScript, IDisposable { }") == "class Script : BaseScript, IDisposable { }");
+  CHECK(rewrite("class Box<T> : List<T> where T : class { } class Script : FalloutBaseScript { }")
+    == "class Box<T> : List<T> where T : class { } class Script : BaseScript { }");
+
+  // using fomm.Scripting; is removed with the preceding whitespaces:
+  CHECK(rewrite("using System;\r\nusing fomm.Scripting;\r\nclass Script : BaseScript { }")
+    == "using System;\r\nclass Script : BaseScript { }");
+  CHECK(rewrite("using fomm.Other;") == "using fomm.Other;");
+
+  // Comments and literals are never rewritten:
+  CHECK(rewrite("// class Script : FalloutBaseScript\n") == "// class Script : FalloutBaseScript\n");
+  CHECK(rewrite("/* using fomm.Scripting; */") == "/* using fomm.Scripting; */");
+  CHECK(rewrite("string s = \"class Script : FalloutBaseScript\";") == "string s = \"class Script : FalloutBaseScript\";");
+  CHECK(rewrite("string s = @\"\"\"class Script : FalloutBaseScript\";") == "string s = @\"\"\"class Script : FalloutBaseScript\";");
+
+  // Nothing to rewrite:
+  CHECK(rewrite("") == "");
+  CHECK(rewrite("class Script : BaseScript { }") == "class Script : BaseScript { }");
+
+  // Wide strings, as used with managed strings:
+  CHECK(rewriteScript(std::wstring_view(L"class Script : FalloutBaseScript { }")) == L"class Script : BaseScript { }");
+
+  // String literals:
+  std::vector<std::string> literals;
+  forEachStringLiteral(std::string_view("a = \"fomod\\\\image.png\"; b = @\"x\"\"y\"; c = 'c'; // \"comment\""),
+    [&](std::string_view, std::string const& content) { literals.push_back(content); });
+  CHECK((literals == std::vector<std::string>{ "fomod\\image.png", "x\"y" }));
+
+  // Calls the literals are arguments of:
+  std::vector<std::pair<std::string, std::string>> arguments;
+  forEachStringLiteral(std::string_view(
+      "BaseScript.GetFileFromMod(\"a.esp\"); Select(new string[] { \"b\" }, Path.Combine(\"c\", \"d\"), \"e\");"
+      " new SelOpt(\"f\"); x = (\"g\");"),
+    [&](std::string_view call, std::string const& content) { arguments.emplace_back(call, content); });
+  CHECK((arguments == std::vector<std::pair<std::string, std::string>>{
+    { "GetFileFromMod", "a.esp" }, { "Select", "b" }, { "Combine", "c" }, { "Combine", "d" }, { "Select", "e" },
+    { "SelOpt", "f" }, { "", "g" } }));
+
+  return testResult();
+}
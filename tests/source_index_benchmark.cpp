@@ -0,0 +1,46 @@
+#include "source_index.h"
+
+#include <vector>
+
+#include "bench.h"
+#include "memory_tree.h"
+
+using namespace MOBase;
+
+/**
+ * Look up every file of a 20k-file archive, as scripts installing files one by one do,
+ * with SourceIndex and with IFileTree::find().
+ */
+int main() {
+  auto tree = MemoryTree::create();
+  std::vector<QString> paths;
+  for (int i = 0; i < 20; ++i) {
+    for (int j = 0; j < 50; ++j) {
+      for (int k = 0; k < 20; ++k) {
+        paths.push_back(QString("Data/Textures/Armor%1/Set%2/Part%3.dds").arg(i).arg(j).arg(k));
+        tree->addFile(paths.back());
+      }
+    }
+  }
+
+  measure("SourceIndex construction", 5, [&] { return SourceIndex(tree).size(); });
+
+  const SourceIndex index(tree);
+  const double find = measure("IFileTree::find()", 20, [&] {
+    std::size_t found = 0;
+    for (QString const& path : paths) {
+      found += tree->find(path) != nullptr;
+    }
+    return found;
+  });
+  const double indexed = measure("SourceIndex::find()", 20, [&] {
+    std::size_t found = 0;
+    for (QString const& path : paths) {
+      found += index.find(path) != SourceIndex::NONE;
+    }
+    return found;
+  });
+
+  std::printf("Speed-up: %.1fx\n", find / indexed);
+  return 0;
+}
@@ -0,0 +1,52 @@
+#include "source_index.h"
+
+#include "check.h"
+#include "memory_tree.h"
+
+using namespace MOBase;
+
+int main() {
+  auto tree = MemoryTree::create();
+  tree->addFile("fomod/script.cs");
+  tree->addFile("fomod/images/Option.png");
+  tree->addFile("Data/Textures/Armor.dds");
+  tree->addFile("Data/Plugin.esp");
+  tree->addDirectory("Data/Empty");
+
+  const SourceIndex index(tree);
+  CHECK(index.size() == 10);
+  CHECK(index.entry(SourceIndex::ROOT) == tree);
+  CHECK(index.entry(SourceIndex::NONE) == nullptr);
+
+  // Look-ups, case-insensitive, with both separators and . components:
+  const int plugin = index.find("data/PLUGIN.ESP");
+  CHECK(plugin != SourceIndex::NONE);
+  CHECK(index.entry(plugin) == tree->find("Data/Plugin.esp"));
+  CHECK(index.find("Data\\Textures\\armor.dds") == index.find("./data/textures//Armor.dds"));
+  CHECK(index.find("") == SourceIndex::ROOT);
+  CHECK(index.find("Data/Missing.esp") == SourceIndex::NONE);
+  CHECK(index.find("Data/Plugin.esp/x") == SourceIndex::NONE);
+
+  // Relative look-ups:
+  const int data = index.find("Data");
+  CHECK(index.find("textures/armor.dds", data) == index.find("Data/Textures/Armor.dds"));
+  CHECK(index.find("x", SourceIndex::NONE) == SourceIndex::NONE);
+
+  // Structure, in pre-order:
+  CHECK(index.isDir(data));
+  CHECK(index.isFile(plugin));
+  CHECK(index.isDir(index.find("Data/Empty")));
+  CHECK(index.parent(plugin) == data);
+  CHECK(index.parent(SourceIndex::ROOT) == SourceIndex::NONE);
+  CHECK(index.end(SourceIndex::ROOT) == index.size());
+  CHECK(plugin > data && plugin < index.end(data));
+  CHECK(index.find("fomod/script.cs") >= index.end(data) || index.find("fomod/script.cs") < data);
+
+  // Names and paths keep the original case:
+  CHECK(index.name(plugin) == QLatin1String("Plugin.esp"));
+  CHECK(index.path(plugin) == "Data/Plugin.esp");
+  CHECK(index.path(index.find("fomod/images/option.png"), '\\') == "fomod\\images\\Option.png");
+  CHECK(index.path(SourceIndex::ROOT).isEmpty());
+
+  return testResult();
+}
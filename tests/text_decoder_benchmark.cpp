@@ -0,0 +1,61 @@
+#include "text_decoder.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QTextCodec>
+
+#include "bench.h"
+
+using namespace TextDecoder;
+
+/**
+ * Decode large text files with TextDecoder and with QTextCodec (detection from the BOM,
+ * UTF-8 by default, as QTextStream did before).
+ */
+
+static QString decodeWithDecoder(QByteArray const& data) {
+  auto bytes = reinterpret_cast<const unsigned char*>(data.constData());
+  auto detection = detect(bytes, data.size(), false);
+  const std::size_t length = data.size() - detection.offset;
+
+  QString text(static_cast<int>(maxDecodedSize(detection.encoding, length)), Qt::Uninitialized);
+  text.truncate(static_cast<int>(decode(bytes + detection.offset, length, detection.encoding, reinterpret_cast<char16_t*>(text.data()))));
+  return text;
+}
+
+static QString decodeWithCodec(QByteArray const& data) {
+  static QTextCodec* utf8 = QTextCodec::codecForName("UTF-8");
+  return QTextCodec::codecForUtfText(data, utf8)->toUnicode(data);
+}
+
+int main() {
+  // About 1 MB of script, mostly ASCII with a few accented characters:
+  const QString comment = QString(" // ") + QChar(0xC9) + "l" + QChar(0xE9) + "ments\r\n";
+  QString text;
+  for (int i = 0; i < 20000; ++i) {
+    text += QString("  InstallFileFromMod(\"Textures\\\\Armure%1.dds\");").arg(i) + comment;
+  }
+
+  struct Input {
+    const char* name;
+    QByteArray data;
+  };
+  const Input inputs[] = {
+    { "UTF-8", text.toUtf8() },
+    { "UTF-8 with BOM", "\xEF\xBB\xBF" + text.toUtf8() },
+    { "UTF-16LE with BOM", QByteArray("\xFF\xFE", 2) + QByteArray(reinterpret_cast<const char*>(text.utf16()), text.size() * 2) },
+  };
+
+  for (auto const& input : inputs) {
+    std::printf("%s, %d bytes:\n", input.name, input.data.size());
+    if (decodeWithCodec(input.data) != decodeWithDecoder(input.data)) {
+      std::printf("  The decoded texts differ.\n");
+    }
+
+    const double codec = measure("  QTextCodec", 20, [&] { return decodeWithCodec(input.data).size(); });
+    const double decoder = measure("  TextDecoder", 20, [&] { return decodeWithDecoder(input.data).size(); });
+    std::printf("  Speed-up: %.1fx\n", codec / decoder);
+  }
+
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include "text_decoder.h"
+
+#include <string>
+#include <string_view>
+
+#include "check.h"
+
+using namespace TextDecoder;
+
+static const unsigned char* bytes(std::string_view data) {
+  return reinterpret_cast<const unsigned char*>(data.data());
+}
+
+static std::u16string decode(std::string_view data, bool xml = false) {
+  Detection detection = detect(bytes(data), data.size(), xml);
+  std::u16string result(maxDecodedSize(detection.encoding, data.size() - detection.offset), u'\0');
+  result.resize(TextDecoder::decode(bytes(data) + detection.offset, data.size() - detection.offset, detection.encoding, result.data()));
+  return result;
+}
+
+int main() {
+
+  // Detection from the BOM:
+  CHECK(detect(bytes("\xEF\xBB\xBFx"), 4, false).encoding == Encoding::UTF8);
+  CHECK(detect(bytes("\xEF\xBB\xBFx"), 4, false).offset == 3);
+  CHECK(detect(bytes("\xFF\xFEx\0"), 4, false).encoding == Encoding::UTF16LE);
+  CHECK(detect(bytes("\xFE\xFF\0x"), 4, false).encoding == Encoding::UTF16BE);
+
+  // UTF-16 XML without BOM:
+  CHECK(detect(bytes("<\0?\0x\0m\0l\0"), 10, true).encoding == Encoding::UTF16LE);
+  CHECK(detect(bytes("\0<\0?\0x\0m\0l"), 10, true).encoding == Encoding::UTF16BE);
+
+  // 8-bit files declared as UTF-16 are not UTF-16, and declared 8-bit encodings are used:
+  CHECK(detect(bytes("<?xml encoding=\"UTF-16\"?>"), 25, true).encoding == Encoding::UTF8);
+  CHECK(detect(bytes("<?xml encoding='ISO-8859-1'?>\xC3\xA9"), 31, true).encoding == Encoding::WINDOWS_1252);
+
+  // UTF-8 validity, falling back to Windows-1252:
+  CHECK(isValidUtf8(bytes("abc\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80"), 12));
+  CHECK(!isValidUtf8(bytes("\xC0\xAF"), 2));         // Overlong.
+  CHECK(!isValidUtf8(bytes("\xED\xA0\x80"), 3));     // Surrogate.
+  CHECK(!isValidUtf8(bytes("abc\xE2\x82"), 5));      // Truncated.
+  CHECK(detect(bytes("caf\xE9"), 4, false).encoding == Encoding::WINDOWS_1252);
+
+  // Decoding, with the ASCII fast path (more than 16 bytes) and without:
+  CHECK(decode("") == u"");
+  CHECK(decode("using System; class Script : BaseScript { }") == u"using System; class Script : BaseScript { }");
+  CHECK(decode("\xEF\xBB\xBF" "abcdefghijklmnopqrstuvwxyz\xC3\xA9\xF0\x9F\x98\x80z") == u"abcdefghijklmnopqrstuvwxyzé\U0001F600z");
+  CHECK(decode("caf\xE9 \x80\x9F") == u"café €Ÿ");
+  CHECK(decode(std::string_view("\xFF\xFEh\0\xE9\0", 6)) == u"hé");
+  CHECK(decode(std::string_view("\xFE\xFF\0h\x20\xAC", 6)) == u"h€");
+
+  // Invalid sequences are replaced (only possible when UTF-8 is forced):
+  std::u16string out(4, u'\0');
+  out.resize(TextDecoder::decode(bytes("a\xC3z"), 3, Encoding::UTF8, out.data()));
+  CHECK(out == u"a�z");
+
+  return testResult();
+}
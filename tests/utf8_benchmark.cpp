@@ -0,0 +1,75 @@
+#include "utf8.h"
+
+#include <codecvt>
+#include <locale>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "bench.h"
+
+/**
+ * Transcode 10k strings (paths and messages, as logged by scripts) from UTF-16 to UTF-8
+ * and back with Utf8, and with the conversions of the platform: marshal_as<std::string>
+ * and marshal_as<String^> are thin wrappers around WideCharToMultiByte and
+ * MultiByteToWideChar, which are measured on Windows (the tests do not use the CLR), and
+ * std::wstring_convert is measured everywhere.
+ */
+int main() {
+  std::vector<std::u16string> strings;
+  for (int i = 0; i < 10000; ++i) {
+    const std::string n = std::to_string(i);
+    strings.push_back(u"Data\\Textures\\Armor\\Iron\\Cuirass_" + std::u16string(n.begin(), n.end()) + u".dds");
+    if (i % 10 == 0) {
+      strings.back() += u" (déjà installé)";
+    }
+  }
+
+  const double utf8 = measure("Utf8::encode() and Utf8::decode()", 20, [&] {
+    std::size_t size = 0;
+    std::string narrow;
+    std::u16string wide;
+    for (auto const& string : strings) {
+      narrow.resize(Utf8::maxEncodedSize(string.size()));
+      narrow.resize(Utf8::encode(string.data(), string.size(), narrow.data()));
+      wide.resize(Utf8::maxDecodedSize(narrow.size()));
+      wide.resize(Utf8::decode(narrow.data(), narrow.size(), wide.data()));
+      size += wide.size();
+    }
+    return size;
+  });
+
+  const double convert = measure("std::wstring_convert", 20, [&] {
+    std::wstring_convert<std::codecvt_utf8_utf16<char16_t>, char16_t> converter;
+    std::size_t size = 0;
+    for (auto const& string : strings) {
+      size += converter.from_bytes(converter.to_bytes(string)).size();
+    }
+    return size;
+  });
+  std::printf("Speed-up: %.1fx over std::wstring_convert\n", convert / utf8);
+
+#ifdef _WIN32
+  for (UINT codePage : { CP_ACP, CP_UTF8 }) {
+    const double windows = measure(codePage == CP_ACP ? "WideCharToMultiByte (CP_ACP) and back" : "WideCharToMultiByte (CP_UTF8) and back", 20, [&] {
+      std::size_t size = 0;
+      for (auto const& string : strings) {
+        auto data = reinterpret_cast<const wchar_t*>(string.data());
+        const int length = static_cast<int>(string.size());
+        std::string narrow(WideCharToMultiByte(codePage, 0, data, length, nullptr, 0, nullptr, nullptr), '\0');
+        WideCharToMultiByte(codePage, 0, data, length, narrow.data(), static_cast<int>(narrow.size()), nullptr, nullptr);
+        std::wstring wide(MultiByteToWideChar(codePage, 0, narrow.data(), static_cast<int>(narrow.size()), nullptr, 0), L'\0');
+        MultiByteToWideChar(codePage, 0, narrow.data(), static_cast<int>(narrow.size()), wide.data(), static_cast<int>(wide.size()));
+        size += wide.size();
+      }
+      return size;
+    });
+    std::printf("Speed-up: %.1fx\n", windows / utf8);
+  }
+#endif
+
+  return 0;
+}
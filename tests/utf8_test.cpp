@@ -0,0 +1,49 @@
+#include "utf8.h"
+
+#include <string>
+#include <string_view>
+
+#include "check.h"
+
+static std::string encode(std::u16string_view value) {
+  std::string result(Utf8::maxEncodedSize(value.size()), '\0');
+  result.resize(Utf8::encode(value.data(), value.size(), result.data()));
+  return result;
+}
+
+static std::u16string decode(std::string_view value) {
+  std::u16string result(Utf8::maxDecodedSize(value.size()), u'\0');
+  result.resize(Utf8::decode(value.data(), value.size(), result.data()));
+  return result;
+}
+
+int main() {
+
+  // ASCII, shorter and longer than the SIMD blocks:
+  CHECK(encode(u"") == "");
+  CHECK(encode(u"Data") == "Data");
+  CHECK(encode(u"Data\\Textures\\Armor\\Iron\\Cuirass_n.dds") == "Data\\Textures\\Armor\\Iron\\Cuirass_n.dds");
+
+  // Non-ASCII characters at the start, in the middle and at the end of a block:
+  CHECK(encode(u"été") == "\xC3\xA9t\xC3\xA9");
+  CHECK(encode(u"abcdefghijklmnoé") == "abcdefghijklmno\xC3\xA9");
+  CHECK(encode(u"abcdefghijklmnopé€") == "abcdefghijklmnop\xC3\xA9\xE2\x82\xAC");
+  CHECK(encode(u"Привет") == "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82");
+
+  // Surrogate pairs, and unpaired surrogates replaced by U+FFFD:
+  CHECK(encode(u"x\U0001F600y") == "x\xF0\x9F\x98\x80y");
+  CHECK(encode(std::u16string(1, char16_t(0xD800)) + u"a") == "\xEF\xBF\xBD" "a");
+  CHECK(encode(u"a" + std::u16string(1, char16_t(0xDC00))) == "a\xEF\xBF\xBD");
+  CHECK(encode(std::u16string(2, char16_t(0xD800))) == "\xEF\xBF\xBD\xEF\xBF\xBD");
+
+  // Round-trips:
+  for (std::u16string_view value : { u"", u"plain ascii text that is longer than sixteen characters",
+    u"Skyrim Special Edition/Données/été", u"日本語のファイル名.esp", u"\U0001F600\U0001F601 emoji" }) {
+    CHECK(decode(encode(value)) == value);
+  }
+
+  // Invalid UTF-8 is replaced by U+FFFD when decoding:
+  CHECK(decode("a\xFFz") == u"a�z");
+
+  return testResult();
+}
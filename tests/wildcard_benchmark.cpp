@@ -0,0 +1,67 @@
+#include "wildcard.h"
+
+#include <vector>
+
+#include <QDir>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+
+#include "bench.h"
+
+/**
+ * Match the names of a 50k-file listing against a filter with WildcardMatcher, with
+ * QDir::match() (used before, which compiles the filter on every call) and with
+ * wildcard regular expressions compiled once.
+ */
+int main() {
+  const QString filter = "*.esp;*.esm;Textures*.bsa";
+
+  std::vector<QString> names;
+  for (int i = 0; i < 10000; ++i) {
+    names.push_back(QString("Armor%1.dds").arg(i));
+    names.push_back(QString("Plugin%1.ESP").arg(i));
+    names.push_back(QString("Master%1.esm").arg(i));
+    names.push_back(QString("Textures%1.bsa").arg(i));
+    names.push_back(QString("Readme%1.txt").arg(i));
+  }
+
+  const WildcardMatcher matcher(std::u16string_view(reinterpret_cast<const char16_t*>(filter.utf16()), filter.size()));
+
+  std::vector<QRegularExpression> expressions;
+  for (QString const& pattern : filter.split(';')) {
+    expressions.emplace_back(QRegularExpression::wildcardToRegularExpression(pattern), QRegularExpression::CaseInsensitiveOption);
+  }
+
+  const double dir = measure("QDir::match()", 5, [&] {
+    std::size_t count = 0;
+    for (QString const& name : names) {
+      count += QDir::match(filter, name);
+    }
+    return count;
+  });
+
+  const double regex = measure("QRegularExpression (compiled once)", 5, [&] {
+    std::size_t count = 0;
+    for (QString const& name : names) {
+      for (auto const& expression : expressions) {
+        if (expression.match(name).hasMatch()) {
+          ++count;
+          break;
+        }
+      }
+    }
+    return count;
+  });
+
+  const double wildcard = measure("WildcardMatcher", 5, [&] {
+    std::size_t count = 0;
+    for (QString const& name : names) {
+      count += matcher.matches(std::u16string_view(reinterpret_cast<const char16_t*>(name.utf16()), name.size()));
+    }
+    return count;
+  });
+
+  std::printf("Speed-up: %.1fx over QDir::match(), %.1fx over QRegularExpression\n", dir / wildcard, regex / wildcard);
+  return 0;
+}
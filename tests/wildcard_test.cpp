@@ -0,0 +1,48 @@
+#include "wildcard.h"
+
+#include "check.h"
+
+static bool match(std::u16string_view filter, std::u16string_view name) {
+  return WildcardMatcher(filter).matches(name);
+}
+
+int main() {
+
+  // Literals, case-insensitive (including non-ASCII letters):
+  CHECK(match(u"Skyrim.esm", u"skyrim.ESM"));
+  CHECK(match(u"ÉTÉ.esp", u"été.esp"));
+  CHECK(match(u"Привет.esp", u"привет.ESP"));
+  CHECK(!match(u"skyrim.esm", u"skyrim.esp"));
+
+  // Stars and question marks:
+  CHECK(match(u"*", u""));
+  CHECK(match(u"*.dds", u"texture.dds"));
+  CHECK(!match(u"*.dds", u"texture.dds.bak"));
+  CHECK(match(u"a*b*c", u"aXXbYYbc"));
+  CHECK(match(u"a**c", u"ac"));
+  CHECK(match(u"?.esp", u"a.esp"));
+  CHECK(!match(u"?.esp", u".esp"));
+
+  // Sets, ranges and negation:
+  CHECK(match(u"file[0-9].txt", u"file5.txt"));
+  CHECK(!match(u"file[0-9].txt", u"fileA.txt"));
+  CHECK(match(u"file[!0-9].txt", u"fileA.txt"));
+  CHECK(match(u"file[^0-9].txt", u"fileA.txt"));
+  CHECK(match(u"[a-c]*", u"Bravo"));
+  CHECK(match(u"[]]", u"]"));
+  CHECK(match(u"[abc", u"[abc"));
+
+  // Multiple patterns, split on semicolons or, if there is none, on spaces:
+  CHECK(match(u"*.esp;*.esm", u"a.esm"));
+  CHECK(match(u"*.esp *.esm", u"a.esm"));
+  CHECK(match(u"My Mod*.esp;*.esm", u"my mod 2.esp"));
+  CHECK(!match(u"My Mod*.esp;*.esm", u"Mod.esp"));
+  CHECK(match(u" *.esp ; *.dds ", u"a.dds"));
+
+  // An empty filter matches nothing:
+  CHECK(WildcardMatcher(u"").empty());
+  CHECK(!match(u"", u"a"));
+  CHECK(!match(u" ; ", u"a"));
+
+  return testResult();
+}